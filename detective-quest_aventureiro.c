@@ -5,92 +5,90 @@
  * Este programa simula a exploração de uma mansão representada por uma
  * árvore binária, onde cada nó representa um cômodo que pode conter pistas.
  * As pistas coletadas são armazenadas em uma BST e exibidas em ordem alfabética.
+ * As árvores são geradas pelas macros de estruturas.h.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "estruturas.h"
+
+// Chaves e comparações usadas pelas estruturas geradas
+#define TEXTO_DA_PISTA(no) (&(const TextoOrdenado){ (no)->pista, (no)->pista + (no)->tamanho + 1, \
+                                                   (no)->tamanho, (no)->tamanhoChave })
+#define COMPARAR_PISTA(chave, no) compararTextosOrdenados((chave), TEXTO_DA_PISTA(no))
+#define TAMANHO_PISTA_ORDENADA(chave) ((chave)->tamanho + 1 + (chave)->tamanhoChave)
+#define COPIAR_PISTA(no, chave)                                                    \
+    ((no)->tamanho = (chave)->tamanho, (no)->tamanhoChave = (chave)->tamanhoChave, \
+     memcpy((no)->pista, (chave)->texto, (chave)->tamanho + 1),                     \
+     memcpy((no)->pista + (chave)->tamanho + 1, (chave)->chave, (chave)->tamanhoChave))
+
 // Estrutura para armazenar pistas em uma árvore BST
-typedef struct PistaNode {
-    char pista[100];                // Conteúdo da pista
-    struct PistaNode *esquerda;     // Subárvore esquerda (pistas menores)
-    struct PistaNode *direita;      // Subárvore direita (pistas maiores)
-} PistaNode;
+// (subárvore esquerda com pistas menores, direita com pistas maiores)
+DEFINIR_MAPA_ORDENADO(PistaNode, diario,
+    unsigned int tamanho;           // Comprimento da pista (sem o \0)
+    unsigned int tamanhoChave;      // Comprimento da chave de ordenação
+    char pista[];                   // Pista, \0 e chave, alocados junto com o nó
+, const TextoOrdenado *, COMPARAR_PISTA, TAMANHO_PISTA_ORDENADA, COPIAR_PISTA)
 
 // Estrutura que representa cada sala da mansão
-typedef struct Sala {
-    char nome[50];                  // Nome do cômodo
-    char pista[100];                // Pista encontrada neste cômodo (vazia se não houver)
-    struct Sala *esquerda;          // Ponteiro para sala à esquerda
-    struct Sala *direita;           // Ponteiro para sala à direita
-} Sala;
+DEFINIR_ARVORE_BINARIA(Sala, sala,
+    const char *nome;               // Nome do cômodo
+    const char *pista;              // Pista encontrada neste cômodo (vazia se não houver)
+)
 
-/*
- * Função: criarSala
- * Descrição: Cria dinamicamente uma nova sala com nome e pista opcional
- * Parâmetros:
- *   - nome: string com o nome do cômodo
- *   - pista: string com a pista (pode ser "" se não houver pista)
- * Retorno: ponteiro para a sala criada
- */
-Sala* criarSala(const char *nome, const char *pista) {
-    // Aloca memória dinamicamente para a nova sala
-    Sala *novaSala = (Sala*)malloc(sizeof(Sala));
-    
-    // Verifica se a alocação foi bem-sucedida
-    if (novaSala == NULL) {
-        printf("Erro ao alocar memória para sala!\n");
-        exit(1);
-    }
-    
-    // Copia o nome e a pista para a estrutura
-    strcpy(novaSala->nome, nome);
-    strcpy(novaSala->pista, pista);
-    
-    // Inicializa os ponteiros como NULL
-    novaSala->esquerda = NULL;
-    novaSala->direita = NULL;
-    
-    return novaSala;
-}
+// Índices das salas na tabela da mansão
+enum {
+    HALL, SALA_ESTAR, COZINHA,
+    BIBLIOTECA, ESCRITORIO, DESPENSA, JARDIM,
+    SALA_SECRETA, SALA_LEITURA, COFRE, ESTUFA,
+    TOTAL_SALAS
+};
+
+// Mapa da mansão com as pistas de cada cômodo, montado pelo compilador em
+// memória somente leitura: iniciar o jogo não aloca nem copia strings
+static const Sala mansao[TOTAL_SALAS] = {
+    // Nível 0 - Entrada
+    [HALL]         = { "Hall de Entrada", "Pegadas molhadas no tapete",
+                       &mansao[SALA_ESTAR], &mansao[COZINHA] },
+    // Nível 1
+    [SALA_ESTAR]   = { "Sala de Estar", "",
+                       &mansao[BIBLIOTECA], &mansao[ESCRITORIO] },
+    [COZINHA]      = { "Cozinha", "Faca desaparecida do bloco",
+                       &mansao[DESPENSA], &mansao[JARDIM] },
+    // Nível 2
+    [BIBLIOTECA]   = { "Biblioteca", "Livro aberto sobre venenos",
+                       &mansao[SALA_SECRETA], &mansao[SALA_LEITURA] },
+    [ESCRITORIO]   = { "Escritório", "", &mansao[COFRE], NULL },
+    [DESPENSA]     = { "Despensa", "Frasco vazio de arsênico", NULL, NULL },
+    [JARDIM]       = { "Jardim", "", NULL, &mansao[ESTUFA] },
+    // Nível 3
+    [SALA_SECRETA] = { "Sala Secreta", "Documento queimado parcialmente", NULL, NULL },
+    [SALA_LEITURA] = { "Sala de Leitura", "Carta ameaçadora escondida", NULL, NULL },
+    [COFRE]        = { "Cofre", "Testamento adulterado", NULL, NULL },
+    [ESTUFA]       = { "Estufa", "Planta venenosa cultivada", NULL, NULL },
+};
 
 /*
  * Função: inserirPista
- * Descrição: Insere uma nova pista na árvore BST de forma ordenada
+ * Descrição: Insere uma nova pista na árvore BST em ordem alfabética
+ *            (acentos e maiúsculas não alteram a posição)
  * Parâmetros:
  *   - raiz: ponteiro para a raiz da árvore de pistas
  *   - pista: string com a pista a ser inserida
  * Retorno: ponteiro para a raiz da árvore (pode ser alterada)
  */
 PistaNode* inserirPista(PistaNode *raiz, const char *pista) {
-    // Caso base: posição encontrada para inserção
-    if (raiz == NULL) {
-        PistaNode *novaPista = (PistaNode*)malloc(sizeof(PistaNode));
-        
-        if (novaPista == NULL) {
-            printf("Erro ao alocar memória para pista!\n");
-            exit(1);
-        }
-        
-        strcpy(novaPista->pista, pista);
-        novaPista->esquerda = NULL;
-        novaPista->direita = NULL;
-        
-        return novaPista;
-    }
-    
-    // Compara a pista com o nó atual para decidir o lado de inserção
-    int comparacao = strcmp(pista, raiz->pista);
+    PistaNode *novaPista;
+    char chaveLocal[TAMANHO_CHAVE_LOCAL];
+    TextoOrdenado texto;
     
-    if (comparacao < 0) {
-        // Pista é menor alfabeticamente, vai para a esquerda
-        raiz->esquerda = inserirPista(raiz->esquerda, pista);
-    } else if (comparacao > 0) {
-        // Pista é maior alfabeticamente, vai para a direita
-        raiz->direita = inserirPista(raiz->direita, pista);
-    }
-    // Se comparacao == 0, a pista já existe (não insere duplicata)
+    // A chave de ordenação é montada uma vez; a descida só faz memcmp.
+    // Se a pista já existe, a árvore não muda (não insere duplicata)
+    ordenarTexto(&texto, pista, chaveLocal, sizeof(chaveLocal));
+    raiz = diario_inserir(raiz, &texto, &novaPista);
+    soltarTextoOrdenado(&texto, chaveLocal);
     
     return raiz;
 }
@@ -121,9 +119,8 @@ void exibirPistas(PistaNode *raiz) {
  *   - arvorePistas: ponteiro para ponteiro da árvore de pistas (para modificá-la)
  * Retorno: void
  */
-void explorarSalasComPistas(Sala *salaAtual, PistaNode **arvorePistas) {
+void explorarSalasComPistas(const Sala *salaAtual, PistaNode **arvorePistas) {
     char escolha;
-    int pistasTotais = 0;
     
     // Loop principal de exploração
     while (salaAtual != NULL) {
@@ -139,7 +136,6 @@ void explorarSalasComPistas(Sala *salaAtual, PistaNode **arvorePistas) {
             
             // Adiciona a pista à árvore BST
             *arvorePistas = inserirPista(*arvorePistas, salaAtual->pista);
-            pistasTotais++;
             
             printf("\n   [Pista adicionada ao diário do detetive]\n");
         } else {
@@ -147,7 +143,7 @@ void explorarSalasComPistas(Sala *salaAtual, PistaNode **arvorePistas) {
         }
         
         // Verifica se é uma sala sem saídas
-        if (salaAtual->esquerda == NULL && salaAtual->direita == NULL) {
+        if (sala_ehFolha(salaAtual)) {
             printf("\n⚠️  Esta sala não possui mais caminhos!\n");
             printf("    Você pode sair para revisar as pistas coletadas.\n");
         }
@@ -161,7 +157,7 @@ void explorarSalasComPistas(Sala *salaAtual, PistaNode **arvorePistas) {
             printf("  [D] - Ir para a direita\n");
         }
         printf("  [S] - Sair e revisar pistas coletadas\n");
-        printf("\nPistas coletadas até agora: %d\n", pistasTotais);
+        printf("\nPistas coletadas até agora: %d\n", diario_contar(*arvorePistas));
         printf("\nSua escolha: ");
         
         // Lê a escolha do jogador
@@ -194,26 +190,6 @@ void explorarSalasComPistas(Sala *salaAtual, PistaNode **arvorePistas) {
     }
 }
 
-/*
- * Função: liberarArvore
- * Descrição: Libera toda a memória alocada para a árvore de salas
- * Parâmetros:
- *   - raiz: ponteiro para a raiz da árvore
- * Retorno: void
- */
-void liberarArvore(Sala *raiz) {
-    if (raiz == NULL) {
-        return;
-    }
-    
-    // Libera recursivamente as subárvores
-    liberarArvore(raiz->esquerda);
-    liberarArvore(raiz->direita);
-    
-    // Libera o nó atual
-    free(raiz);
-}
-
 /*
  * Função: liberarArvorePistas
  * Descrição: Libera toda a memória alocada para a árvore de pistas
@@ -222,22 +198,13 @@ void liberarArvore(Sala *raiz) {
  * Retorno: void
  */
 void liberarArvorePistas(PistaNode *raiz) {
-    if (raiz == NULL) {
-        return;
-    }
-    
-    // Libera recursivamente as subárvores
-    liberarArvorePistas(raiz->esquerda);
-    liberarArvorePistas(raiz->direita);
-    
-    // Libera o nó atual
-    free(raiz);
+    diario_liberar(raiz);
 }
 
 /*
  * Função: main
- * Descrição: Ponto de entrada do programa. Cria o mapa da mansão com pistas
- *            e gerencia o sistema de exploração e coleta
+ * Descrição: Ponto de entrada do programa. Gerencia o sistema de exploração
+ *            e coleta sobre o mapa estático da mansão
  * Retorno: 0 se execução bem-sucedida
  */
 int main() {
@@ -252,45 +219,8 @@ int main() {
     // Inicializa a árvore BST de pistas (vazia no início)
     PistaNode *arvorePistas = NULL;
     
-    // Criação da estrutura da mansão com pistas
-    
-    // Nível 0 - Entrada
-    Sala *hall = criarSala("Hall de Entrada", "Pegadas molhadas no tapete");
-    
-    // Nível 1
-    Sala *salaEstar = criarSala("Sala de Estar", "");
-    Sala *cozinha = criarSala("Cozinha", "Faca desaparecida do bloco");
-    hall->esquerda = salaEstar;
-    hall->direita = cozinha;
-    
-    // Nível 2 - Ramificações da Sala de Estar
-    Sala *biblioteca = criarSala("Biblioteca", "Livro aberto sobre venenos");
-    Sala *escritorio = criarSala("Escritório", "");
-    salaEstar->esquerda = biblioteca;
-    salaEstar->direita = escritorio;
-    
-    // Nível 2 - Ramificações da Cozinha
-    Sala *despensa = criarSala("Despensa", "Frasco vazio de arsênico");
-    Sala *jardim = criarSala("Jardim", "");
-    cozinha->esquerda = despensa;
-    cozinha->direita = jardim;
-    
-    // Nível 3 - Ramificações da Biblioteca
-    Sala *salaSecreta = criarSala("Sala Secreta", "Documento queimado parcialmente");
-    Sala *salaLeitura = criarSala("Sala de Leitura", "Carta ameaçadora escondida");
-    biblioteca->esquerda = salaSecreta;
-    biblioteca->direita = salaLeitura;
-    
-    // Nível 3 - Ramificações do Escritório
-    Sala *cofre = criarSala("Cofre", "Testamento adulterado");
-    escritorio->esquerda = cofre;
-    
-    // Nível 3 - Ramificações do Jardim
-    Sala *estufa = criarSala("Estufa", "Planta venenosa cultivada");
-    jardim->direita = estufa;
-    
-    // Inicia a exploração com coleta de pistas
-    explorarSalasComPistas(hall, &arvorePistas);
+    // Inicia a exploração com coleta de pistas pelo mapa estático
+    explorarSalasComPistas(&mansao[HALL], &arvorePistas);
     
     // Exibe o resumo das pistas coletadas
     printf("\n==============================================\n");
@@ -306,7 +236,6 @@ int main() {
     }
     
     // Libera toda a memória alocada
-    liberarArvore(hall);
     liberarArvorePistas(arvorePistas);
     
     printf("\n==============================================\n");
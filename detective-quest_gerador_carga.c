@@ -0,0 +1,322 @@
+/*
+ * Detective Quest - Gerador de Carga
+ * Enigma Studios
+ *
+ * Cliente de teste do modo servidor do nível Mestre
+ * (detective-quest_mestre --servidor SOCKET). Abre conexões ociosas, que
+ * só recebem a abertura da partida e ficam paradas, e conexões ativas,
+ * que jogam partidas roteirizadas no ritmo pergunta-resposta. A latência
+ * de cada comando vai do envio da linha até o próximo pedido de entrada
+ * (ou até o servidor encerrar a partida).
+ *
+ * Uso: detective-quest_gerador_carga SOCKET [ATIVAS] [PARTIDAS] [OCIOSAS]
+ *   - ATIVAS: conexões jogando ao mesmo tempo (padrão 100)
+ *   - PARTIDAS: partidas jogadas por conexão ativa (padrão 10)
+ *   - OCIOSAS: conexões abertas e paradas durante o teste (padrão 0)
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define MAX_EVENTOS 256      // Eventos tratados por chamada a epoll_wait
+#define TAMANHO_FINAL 64     // Bytes finais da resposta guardados para achar o prompt
+#define MAX_PASSOS 16        // Comandos por roteiro
+
+// Partidas roteirizadas (cada uma termina com a acusação)
+static const char *const roteiros[][MAX_PASSOS] = {
+    { "E", "E", "E", "S", "Mordomo", NULL },
+    { "EED", "S", "Advogado", NULL },
+    { "goto Cofre", "V", "V", "V", "D", "E", "S", "Advogado", NULL },
+    { "D", "D", "D", "U", "V", "E", "S", "Jardineiro", NULL },
+    { "goto Sala Secreta", "goto Sala de Leitura", "goto Cofre", "S", "Advogado", NULL },
+};
+
+#define TOTAL_ROTEIROS ((int)(sizeof(roteiros) / sizeof(roteiros[0])))
+
+// Textos que encerram a resposta quando o servidor espera entrada
+static const char *const prompts[] = { "Sua escolha: ", "suspeito: " };
+
+typedef struct {
+    int descritor;
+    int ativa;                      // 0: conexão ociosa
+    int roteiro;
+    int passo;                      // Próximo comando do roteiro
+    int partidasRestantes;
+    int aguardando;                 // 1 se há comando sem resposta
+    struct timespec envio;          // Momento em que o comando foi enviado
+    char final[TAMANHO_FINAL];      // Fim da resposta recebida até agora
+    size_t tamanhoFinal;
+} ConexaoCliente;
+
+// Latências medidas, em nanossegundos
+typedef struct {
+    unsigned long long *valores;
+    size_t total;
+    size_t capacidade;
+} Amostras;
+
+static const char *caminhoSocket;
+static int epollCliente;
+static Amostras latencias;
+static unsigned long partidasConcluidas;
+static int ativasAbertas;
+
+static long long diferencaNs(const struct timespec *inicio, const struct timespec *fim) {
+    return (long long)(fim->tv_sec - inicio->tv_sec) * 1000000000LL + (fim->tv_nsec - inicio->tv_nsec);
+}
+
+static void registrarLatencia(ConexaoCliente *conexao) {
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+
+    if (latencias.total == latencias.capacidade) {
+        latencias.capacidade = latencias.capacidade > 0 ? 2 * latencias.capacidade : 4096;
+        latencias.valores = (unsigned long long*)realloc(latencias.valores,
+            latencias.capacidade * sizeof(unsigned long long));
+        if (latencias.valores == NULL) {
+            printf("Erro ao alocar memória para as latências!\n");
+            exit(1);
+        }
+    }
+    latencias.valores[latencias.total++] = (unsigned long long)diferencaNs(&conexao->envio, &agora);
+    conexao->aguardando = 0;
+}
+
+/*
+ * Função: conectar
+ * Descrição: Abre uma conexão não bloqueante com o servidor e a registra
+ *            no epoll. Com a fila de conexões do servidor cheia, o connect
+ *            não bloqueante falha com EAGAIN em vez de esperar; tenta de novo.
+ * Retorno: 1 se conectou, 0 em erro (mensagem já exibida)
+ */
+static int conectar(ConexaoCliente *conexao) {
+    struct sockaddr_un endereco = { .sun_family = AF_UNIX };
+    strncpy(endereco.sun_path, caminhoSocket, sizeof(endereco.sun_path) - 1);
+    const struct timespec espera = { .tv_nsec = 100000 };
+    int conectado = 0;
+
+    conexao->descritor = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (conexao->descritor >= 0) {
+        while (!(conectado = connect(conexao->descritor, (struct sockaddr*)&endereco,
+                                     sizeof(endereco)) == 0) && errno == EAGAIN) {
+            nanosleep(&espera, NULL);
+        }
+    }
+    if (!conectado) {
+        printf("Erro ao conectar em \"%s\": %s\n", caminhoSocket, strerror(errno));
+        if (conexao->descritor >= 0) {
+            close(conexao->descritor);
+        }
+        return 0;
+    }
+
+    conexao->passo = 0;
+    conexao->aguardando = 0;
+    conexao->tamanhoFinal = 0;
+    struct epoll_event evento = { .events = EPOLLIN, .data.ptr = conexao };
+    epoll_ctl(epollCliente, EPOLL_CTL_ADD, conexao->descritor, &evento);
+    return 1;
+}
+
+// 1 se a resposta recebida até agora termina em um pedido de entrada
+static int terminaEmPrompt(const ConexaoCliente *conexao) {
+    for (size_t i = 0; i < sizeof(prompts) / sizeof(prompts[0]); i++) {
+        size_t tamanho = strlen(prompts[i]);
+        if (conexao->tamanhoFinal >= tamanho &&
+            memcmp(conexao->final + conexao->tamanhoFinal - tamanho, prompts[i], tamanho) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Envia o próximo comando do roteiro (linhas curtas: cabem no socket)
+static void enviarComando(ConexaoCliente *conexao) {
+    const char *comando = roteiros[conexao->roteiro][conexao->passo];
+    char linha[128];
+
+    if (comando == NULL) {
+        return;  // Roteiro acabou: espera o servidor encerrar
+    }
+    int tamanho = snprintf(linha, sizeof(linha), "%s\n", comando);
+    conexao->passo++;
+    conexao->tamanhoFinal = 0;
+    clock_gettime(CLOCK_MONOTONIC, &conexao->envio);
+    conexao->aguardando = 1;
+    if (send(conexao->descritor, linha, (size_t)tamanho, MSG_NOSIGNAL) != tamanho) {
+        printf("Erro ao enviar comando: %s\n", strerror(errno));
+        exit(1);
+    }
+}
+
+/*
+ * Função: tratarLeitura
+ * Descrição: Lê a resposta do servidor até o socket esvaziar (EAGAIN); no
+ *            prompt, mede e envia o próximo comando. No fim da partida,
+ *            reconecta se ainda há partidas.
+ */
+static void tratarLeitura(ConexaoCliente *conexao) {
+    char buffer[16384];
+    ssize_t lidos;
+
+    for (;;) {
+        lidos = read(conexao->descritor, buffer, sizeof(buffer));
+        if (lidos < 0 && errno == EINTR) {
+            continue;
+        }
+        if (lidos <= 0) {
+            break;  // Servidor encerrou, socket vazio ou erro
+        }
+        // Guarda só o fim da resposta
+        size_t novos = (size_t)lidos;
+        if (novos >= TAMANHO_FINAL) {
+            memcpy(conexao->final, buffer + novos - TAMANHO_FINAL, TAMANHO_FINAL);
+            conexao->tamanhoFinal = TAMANHO_FINAL;
+        } else {
+            size_t manter = conexao->tamanhoFinal + novos > TAMANHO_FINAL
+                          ? TAMANHO_FINAL - novos : conexao->tamanhoFinal;
+            memmove(conexao->final, conexao->final + conexao->tamanhoFinal - manter, manter);
+            memcpy(conexao->final + manter, buffer, novos);
+            conexao->tamanhoFinal = manter + novos;
+        }
+    }
+
+    if (lidos == 0) {
+        // Partida encerrada pelo servidor
+        if (conexao->aguardando) {
+            registrarLatencia(conexao);
+        }
+        close(conexao->descritor);
+        if (!conexao->ativa) {
+            printf("Aviso: conexão ociosa encerrada pelo servidor\n");
+            conexao->descritor = -1;
+            return;
+        }
+        partidasConcluidas++;
+        conexao->roteiro = (conexao->roteiro + 1) % TOTAL_ROTEIROS;
+        if (--conexao->partidasRestantes == 0 || !conectar(conexao)) {
+            conexao->descritor = -1;
+            ativasAbertas--;
+        }
+        return;
+    }
+    if (lidos < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        printf("Erro ao ler do servidor: %s\n", strerror(errno));
+        exit(1);
+    }
+
+    if (conexao->ativa && terminaEmPrompt(conexao)) {
+        if (conexao->aguardando) {
+            registrarLatencia(conexao);
+        }
+        enviarComando(conexao);
+    }
+}
+
+static int compararLatencias(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long*)a;
+    unsigned long long y = *(const unsigned long long*)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil sobre as amostras já ordenadas (posição arredondada para cima)
+static double percentilUs(double fracao) {
+    size_t posicao = (size_t)(fracao * (double)latencias.total);
+    if ((double)posicao < fracao * (double)latencias.total || posicao == 0) {
+        posicao++;
+    }
+    return latencias.valores[posicao - 1] / 1000.0;
+}
+
+/*
+ * Função: main
+ * Descrição: Abre as conexões, conduz as partidas e exibe o relatório
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printf("Uso: %s SOCKET [ATIVAS] [PARTIDAS] [OCIOSAS]\n", argv[0]);
+        return 1;
+    }
+    caminhoSocket = argv[1];
+    int ativas = argc > 2 ? atoi(argv[2]) : 100;
+    int partidas = argc > 3 ? atoi(argv[3]) : 10;
+    int ociosas = argc > 4 ? atoi(argv[4]) : 0;
+    if (ativas < 0 || partidas < 1 || ociosas < 0) {
+        printf("Erro: quantidades inválidas!\n");
+        return 1;
+    }
+
+    epollCliente = epoll_create1(EPOLL_CLOEXEC);
+    ConexaoCliente *conexoes = (ConexaoCliente*)calloc((size_t)(ativas + ociosas) + 1, sizeof(ConexaoCliente));
+    if (epollCliente < 0 || conexoes == NULL) {
+        printf("Erro ao preparar o gerador de carga!\n");
+        return 1;
+    }
+
+    // Ociosas primeiro: o servidor já as mantém quando a carga começa
+    int ociosasAbertas = 0;
+    for (int i = 0; i < ociosas; i++) {
+        ConexaoCliente *conexao = &conexoes[ativas + i];
+        if (!conectar(conexao)) {
+            conexao->descritor = -1;
+            break;
+        }
+        ociosasAbertas++;
+    }
+
+    struct timespec inicio, fim;
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    for (int i = 0; i < ativas; i++) {
+        conexoes[i].ativa = 1;
+        conexoes[i].roteiro = i % TOTAL_ROTEIROS;
+        conexoes[i].partidasRestantes = partidas;
+        if (!conectar(&conexoes[i])) {
+            return 1;
+        }
+        ativasAbertas++;
+    }
+
+    struct epoll_event eventos[MAX_EVENTOS];
+    while (ativasAbertas > 0) {
+        int prontos = epoll_wait(epollCliente, eventos, MAX_EVENTOS, -1);
+        if (prontos < 0 && errno != EINTR) {
+            printf("Erro: epoll_wait falhou: %s\n", strerror(errno));
+            return 1;
+        }
+        for (int i = 0; i < prontos; i++) {
+            tratarLeitura((ConexaoCliente*)eventos[i].data.ptr);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &fim);
+
+    double segundos = diferencaNs(&inicio, &fim) / 1e9;
+    printf("Partidas concluídas: %lu em %.3f s (%.0f partidas/s)\n",
+           partidasConcluidas, segundos, partidasConcluidas / segundos);
+    printf("Conexões ociosas mantidas: %d\n", ociosasAbertas);
+    printf("Comandos: %zu (%.0f comandos/s)\n", latencias.total, latencias.total / segundos);
+    if (latencias.total > 0) {
+        qsort(latencias.valores, latencias.total, sizeof(unsigned long long), compararLatencias);
+        printf("Latência (µs): min %.1f  p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+               latencias.valores[0] / 1000.0, percentilUs(0.50), percentilUs(0.90),
+               percentilUs(0.99), percentilUs(0.999), latencias.valores[latencias.total - 1] / 1000.0);
+    }
+
+    for (int i = 0; i < ativas + ociosas; i++) {
+        if (!conexoes[i].ativa && conexoes[i].descritor > 0) {
+            close(conexoes[i].descritor);
+        }
+    }
+    free(conexoes);
+    free(latencias.valores);
+    close(epollCliente);
+    return 0;
+}
@@ -3,505 +3,5013 @@
  * Enigma Studios
  * 
  * Sistema integrado com:
- * - Árvore binária para navegação na mansão
- * - BST para armazenamento ordenado de pistas
- * - Tabela Hash para associação pista-suspeito
- * - Sistema de julgamento final
+ * - Mansão como grafo de salas em formato CSR (padrão ou carregada de
+ *   arquivo), com rotas por busca em largura ou Dijkstra (goto e P)
+ * - BST persistente para armazenamento ordenado de pistas (versões do
+ *   diário, que permitem desfazer coletas)
+ * - Tabela Hash para associação pista-suspeito, com filtro de Bloom
+ * - Carga paralela de catálogos pista -> suspeito (TSV/CSV)
+ * - Sistema de julgamento final, pontuado por planos de bits
+ * - Dica de rota (H) e planejador de coleta por suspeito (--planejar)
+ * - Modo servidor: várias partidas por um socket Unix, com epoll
+ * - Gravação e repetição de partidas
+ *
+ * As estruturas são geradas pelas macros de estruturas.h, compartilhadas
+ * com os níveis Novato e Aventureiro.
  */
 
+#define _GNU_SOURCE          // accept4
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>       // Pontuação com AVX2, escolhida em tempo de execução
+#endif
+
+#include "estruturas.h"
+
+#define TAMANHO_HASH 20      // Baldes da tabela hash do catálogo padrão
+#define MAX_SUSPEITOS 16     // Suspeitos pontuados sem alocação
+#define TAMANHO_NOME 50      // Maior nome de suspeito (com o \0) em inserirNaHash
+#define MAX_THREADS_CARGA 16 // Threads usadas para carregar um catálogo
+#define BYTES_POR_THREAD (1 << 20) // Menor trecho do arquivo por thread
+#define PALAVRAS_BLOCO_FILTRO 8 // Bloco do filtro de Bloom: 512 bits, uma linha de cache
+#define FUNCOES_FILTRO 6     // Bits ligados por pista no bloco
+#define BITS_POR_PISTA_FILTRO 16 // Tamanho do filtro por pista de capacidade
+#define TAMANHO_ENTRADA 65536 // Bytes lidos da entrada padrão por chamada
+#define TAMANHO_LINHA 256    // Maior comando aceito
+#define MAX_MOVIMENTOS 256   // Movimentos na fila sem alocação (uma linha digitada)
+#define MAX_VERSOES 64       // Versões do diário guardadas sem alocação
+#define MAX_SALAS 64         // Salas com estado de visita sem alocação
+#define MAX_PISTAS_ALCANCE 10 // Pistas listadas pelo comando P
+#define MAX_TRILHA 64        // Salas da trilha guardadas sem alocação
+#define MAX_EVENTOS 256      // Eventos tratados por chamada a epoll_wait
+#define MAX_SESSOES_LIVRES 64 // Sessões encerradas guardadas pelo servidor para reuso
+#define MAGICO_REGISTRO "DQR4" // Início de um arquivo de registro de partidas
+#define BITS_TOKEN 4         // Bits do tipo em cada token do registro
+#define MAX_PISTAS_QUADRO 4096 // Pistas coletáveis pontuadas por conjuntos de bits
+#define PALAVRAS_QUADRO (MAX_PISTAS_QUADRO / 64)
+#define LOTE_SUSPEITOS 4     // Suspeitos pontuados juntos (256 bits, uma palavra de cada)
+#define MAX_SALAS_DICA 12    // Salas mostradas de uma rota planejada
+#define PISTAS_POR_PAGINA 10 // Pistas por página do comando diario
+
+// Chaves e comparações usadas pelas estruturas geradas
+#define CHAVE_PISTA(no) (&(const TextoOrdenado){ (no)->pista, (no)->pista + (no)->tamanho + 1, \
+                                                (no)->tamanho, (no)->tamanhoChave })
+#define PRIORIDADE_PISTA(chave) prioridadePista((chave)->texto)
+#define IGUAL_NOME_SALA(no, chave) (strcasecmp((no)->nome, (chave)) == 0)
+#define IGUAL_PISTA(no, chave) (strcmp((no)->pista, (chave)) == 0)
+#define IGUAL_NOME(no, chave) (strcmp((no)->nome, (chave)) == 0)
+#define COMPARAR_PISTA(chave, no) compararTextosOrdenados((chave), CHAVE_PISTA(no))
+#define TAMANHO_TEXTO(chave) (strlen(chave) + 1)
+#define TAMANHO_PISTA_ORDENADA(chave) ((chave)->tamanho + 1 + (chave)->tamanhoChave)
+#define SEM_TAMANHO_EXTRA(chave) 0
+
+// Diário: o texto e, logo após o \0, a chave de ordenação vão no vetor
+// flexível do próprio nó
+#define COPIAR_PISTA(no, chave)                                                    \
+    ((no)->tamanho = (chave)->tamanho, (no)->tamanhoChave = (chave)->tamanhoChave, \
+     memcpy((no)->pista, (chave)->texto, (chave)->tamanho + 1),                     \
+     memcpy((no)->pista + (chave)->tamanho + 1, (chave)->chave, (chave)->tamanhoChave))
+
+// Hash: o texto fica logo após o nó, na mesma alocação (nós estáticos
+// apontam direto para literais)
+#define COPIAR_PISTA_HASH(no, chave) ((no)->pista = strcpy((char*)((no) + 1), (chave)))
+
+// Nomes da carga de catálogo apontam direto para o arquivo mapeado
+#define APONTAR_NOME(no, chave) ((no)->nome = (chave))
+
+unsigned int funcaoHash(const char *chave);
+struct TabelaHash;
+double taxaFalsoPositivoFiltro(const struct TabelaHash *hash);
+double estimarFalsoPositivoFiltro(const struct TabelaHash *hash);
+
+// Hash polinomial (base 31) de uma string; funcaoHash é a versão medida
+static inline unsigned int hashTexto(const char *chave) {
+    unsigned int hash = 0;
+    while (*chave) {
+        hash = (hash * 31) + (*chave);
+        chave++;
+    }
+    return hash;
+}
+
+// hashTexto sem diferenciar maiúsculas (ASCII, como strcasecmp)
+static inline unsigned int hashTextoSemCaixa(const char *chave) {
+    unsigned int hash = 0;
+    while (*chave) {
+        char c = *chave >= 'A' && *chave <= 'Z' ? (char)(*chave + ('a' - 'A')) : *chave;
+        hash = (hash * 31) + c;
+        chave++;
+    }
+    return hash;
+}
+
+// Hash do filtro de Bloom: FNV-1a de 64 bits, independente de hashTexto,
+// com a mistura final do MurmurHash3 (os bits baixos do FNV variam pouco
+// entre pistas que só diferem no fim)
+static inline uint64_t hashFiltro(const char *chave) {
+    uint64_t hash = 14695981039346656037ull;
+    while (*chave) {
+        hash = (hash ^ (unsigned char)*chave++) * 1099511628211ull;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Filtro de Bloom em blocos: cada pista liga FUNCOES_FILTRO bits de um
+// único bloco de 512 bits, então uma consulta lê uma linha de cache.
+// Os 32 bits altos do hash escolhem o bloco; os baixos geram as posições
+// por hash duplo (posição i = h1 + i * h2).
+static inline void mascaraFiltro(uint64_t hash, uint64_t mascara[PALAVRAS_BLOCO_FILTRO]) {
+    unsigned int h1 = (unsigned int)hash & 0xFFFFu;
+    unsigned int h2 = ((unsigned int)hash >> 16) | 1u;
+    for (int w = 0; w < PALAVRAS_BLOCO_FILTRO; w++) {
+        mascara[w] = 0;
+    }
+    for (int i = 0; i < FUNCOES_FILTRO; i++) {
+        unsigned int posicao = (h1 + (unsigned int)i * h2) & 511u;
+        mascara[posicao / 64] |= 1ull << (posicao % 64);
+    }
+}
+
+static inline size_t inicioBlocoFiltro(unsigned int blocos, uint64_t hash) {
+    return (size_t)((unsigned int)(hash >> 32) & (blocos - 1)) * PALAVRAS_BLOCO_FILTRO;
+}
+
+// Liga os bits da pista (atômico: a carga de catálogo preenche em paralelo)
+static inline void adicionarAoFiltro(uint64_t *filtro, unsigned int blocos, const char *pista) {
+    uint64_t hash = hashFiltro(pista);
+    uint64_t mascara[PALAVRAS_BLOCO_FILTRO];
+    uint64_t *bloco = filtro + inicioBlocoFiltro(blocos, hash);
+    
+    mascaraFiltro(hash, mascara);
+    for (int w = 0; w < PALAVRAS_BLOCO_FILTRO; w++) {
+        if (mascara[w] != 0) {
+            __atomic_fetch_or(&bloco[w], mascara[w], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// 0 se a pista com certeza não está no filtro; 1 se pode estar
+static inline int filtroPodeConter(const uint64_t *filtro, unsigned int blocos, const char *pista) {
+    uint64_t hash = hashFiltro(pista);
+    uint64_t mascara[PALAVRAS_BLOCO_FILTRO];
+    const uint64_t *bloco = filtro + inicioBlocoFiltro(blocos, hash);
+    uint64_t faltando = 0;
+    
+    mascaraFiltro(hash, mascara);
+    for (int w = 0; w < PALAVRAS_BLOCO_FILTRO; w++) {
+        faltando |= mascara[w] & ~bloco[w];
+    }
+    return faltando == 0;
+}
+
+// Blocos do filtro para uma capacidade de pistas (potência de 2)
+static inline unsigned int blocosFiltroPara(int capacidadePistas) {
+    size_t bits = (size_t)(capacidadePistas > 0 ? capacidadePistas : 1) * BITS_POR_PISTA_FILTRO;
+    unsigned int blocos = 1;
+    while ((size_t)blocos * PALAVRAS_BLOCO_FILTRO * 64 < bits) {
+        blocos *= 2;
+    }
+    return blocos;
+}
+
+// Prioridade do nó do diário no treap: hash FNV-1a do texto da pista
+static inline unsigned int prioridadePista(const char *pista) {
+    unsigned int hash = 2166136261u;
+    while (*pista) {
+        hash = (hash ^ (unsigned char)*pista++) * 16777619u;
+    }
+    return hash;
+}
+
+// Nó da tabela hash (lista encadeada para colisões) e os baldes: pista -> id
+DEFINIR_MAPA_HASH(IndicePistas, HashNode, indice,
+    const char *pista;              // Chave: pista
+    int idPista;                    // Linha da pista na matriz de evidências
+, const char *, funcaoHash, IGUAL_PISTA, TAMANHO_TEXTO, COPIAR_PISTA_HASH)
+
+// Nomes de suspeitos -> id, usado para numerar os suspeitos na carga
+DEFINIR_MAPA_HASH(IndiceNomes, NomeNode, nomes,
+    const char *nome;               // Chave: nome (não copiado)
+    int id;
+, const char *, hashTexto, IGUAL_NOME, SEM_TAMANHO_EXTRA, APONTAR_NOME)
 
-#define TAMANHO_HASH 20  // Tamanho da tabela hash
+// Nomes de salas -> id da sala na mansão, sem diferenciar maiúsculas
+DEFINIR_MAPA_HASH(IndiceSalas, SalaNode, salas,
+    const char *nome;               // Chave: nome (não copiado)
+    int id;
+, const char *, hashTextoSemCaixa, IGUAL_NOME_SALA, SEM_TAMANHO_EXTRA, APONTAR_NOME)
 
-// Estrutura para nó da tabela hash (lista encadeada para colisões)
-typedef struct HashNode {
-    char pista[100];                // Chave: pista
-    char suspeito[50];              // Valor: nome do suspeito
-    struct HashNode *proximo;       // Próximo nó em caso de colisão
-} HashNode;
+// Associação pista -> suspeito ainda não compactada
+typedef struct {
+    int idPista;                    // Pista que incrimina
+    int idSuspeito;                 // Suspeito incriminado
+    int peso;                       // Força da evidência
+} Evidencia;
+
+// Contadores do filtro de Bloom de uma tabela (mutáveis mesmo em tabelas const)
+typedef struct {
+    unsigned long long consultas;
+    unsigned long long rejeitadas;      // Descartadas sem tocar nos baldes
+    unsigned long long falsosPositivos; // Passaram pelo filtro, mas não estavam no índice
+} EstatisticasFiltro;
 
-// Estrutura da tabela hash
+// Recursos de um catálogo carregado de arquivo (zerados nas demais tabelas)
 typedef struct {
-    HashNode *tabela[TAMANHO_HASH]; // Array de ponteiros para listas encadeadas
+    char *dados;                    // Arquivo mapeado; pistas e nomes apontam para cá
+    size_t tamanho;                 // Bytes mapeados
+    HashNode *nos;                  // Nós do índice, todos em um único bloco
+} CatalogoArquivo;
+
+// Estrutura da tabela hash. Os vetores têm capacidade fixa, escolhida em
+// inicializarHash ou pela carga do catálogo (que os deixa cheios)
+typedef struct TabelaHash {
+    IndicePistas indice;            // Baldes com as listas encadeadas
+    int totalPistas;                // Pistas distintas (ids 0 a totalPistas-1)
+    int capacidadePistas;
+
+    const char **suspeitos;         // Nomes dos suspeitos, indexados pelo id
+    int totalSuspeitos;
+    int capacidadeSuspeitos;
+
+    // Associações na ordem em que foram inseridas (a carga de catálogo
+    // monta o CSR direto e não as guarda)
+    Evidencia *evidencias;
+    int totalEvidencias;
+    int capacidadeEvidencias;
+
+    // Matriz esparsa pista -> (suspeito, peso) em formato CSR: as evidências
+    // da pista p ficam em [inicioPista[p], inicioPista[p + 1])
+    int *inicioPista;
+    int *suspeitoEvidencia;
+    int *pesoEvidencia;
+    int compactada;                 // 1 se o CSR reflete todas as evidências
+
+    // Filtro de Bloom das pistas do índice, consultado antes dos baldes
+    uint64_t *filtro;               // blocosFiltro blocos de PALAVRAS_BLOCO_FILTRO palavras
+    unsigned int blocosFiltro;      // Potência de 2
+    EstatisticasFiltro *estatisticasFiltro;
+
+    void *memoria;                  // Bloco único com os vetores (NULL se estáticos)
+    CatalogoArquivo arquivo;
 } TabelaHash;
 
-// Estrutura para armazenar pistas em uma árvore BST
-typedef struct PistaNode {
-    char pista[100];                // Conteúdo da pista
-    struct PistaNode *esquerda;     // Subárvore esquerda
-    struct PistaNode *direita;      // Subárvore direita
-} PistaNode;
+// Estrutura para armazenar pistas em uma árvore BST persistente: cada
+// pista nova gera uma versão do diário sem alterar as anteriores
+DEFINIR_MAPA_PERSISTENTE(PistaNode, diario,
+    int idPista;                    // Id da pista na tabela hash (-1 se desconhecida)
+    unsigned int tamanho;           // Comprimento da pista (sem o \0)
+    unsigned int tamanhoChave;      // Comprimento da chave de ordenação
+    char pista[];                   // Pista, \0 e chave, alocados junto com o nó
+, const TextoOrdenado *, COMPARAR_PISTA, CHAVE_PISTA, PRIORIDADE_PISTA, TAMANHO_PISTA_ORDENADA, COPIAR_PISTA)
+
+// Evidências do catálogo cruzadas com as pistas da mansão. Com as pistas
+// coletáveis numeradas (numerarPistas), o diário de cada sessão vira um
+// conjunto de bits. Os pesos ficam fatiados
+// em planos: no plano b, o bit c da palavra do suspeito s está ligado se
+// o bit b do peso da pista c contra s está ligado. O plano 31 vale -2^31,
+// como em complemento de dois, o que cobre pesos negativos. Pontuar um
+// suspeito é então E lógico e contagem de bits, plano a plano.
+typedef struct {
+    int ativo;                      // 0: pistas demais, pontua pelo CSR
+    int totalPistas;                // Pistas coletáveis distintas
+    int palavras;                   // Palavras de 64 bits por conjunto de pistas
+    int planos;                     // Planos de bits dos pesos (até 32)
+    int totalSuspeitos;
+    int colunas;                    // totalSuspeitos arredondado para LOTE_SUSPEITOS
+    const uint64_t *bits;           // [plano][palavra][coluna], alinhado a 32 bytes
+    void *memoria;                  // Bloco de bits
+} QuadroEvidencias;
+
+// Árvore das rotas mais curtas a partir da entrada, usada pelo planejador
+typedef struct {
+    const int *ordem;               // Salas alcançáveis, cada pai antes dos filhos
+    int totalOrdem;
+    const int *pai;                 // -1 na entrada e nas salas inalcançáveis
+    const int *inicioFilhos;        // Filhos de s em [inicioFilhos[s], inicioFilhos[s + 1])
+    const int *filhos;
+    const int *pistaCatalogo;       // Id no catálogo da pista de cada sala (-1 se não há)
+    void *memoria;
+} ArvoreRotas;
+
+// Rótulos das portas. As saídas E/D e a volta V reproduzem o mapa
+// clássico em árvore; as demais portas são escolhidas pelo número
+#define PORTA_NUMERADA '\0'
+
+// Mapa da mansão como grafo em formato CSR: as portas da sala s ficam em
+// [inicioPortas[s], inicioPortas[s + 1]) de destinoPorta, custoPorta e
+// rotuloPorta. Ciclos, escadas de mão única e salas com muitas portas
+// são permitidos. Somente leitura depois de montado: todas as sessões
+// compartilham o mesmo grafo.
+typedef struct {
+    int totalSalas;
+    int totalPortas;
+    int entrada;                    // Sala onde a partida começa
+    const char *const *nomes;       // Nome de cada sala
+    const char *const *pistas;      // Pista de cada sala ("" se não há)
+    const int *inicioPortas;
+    const int *destinoPorta;
+    const unsigned int *custoPorta; // NULL: todas as portas custam 1 (busca em largura)
+    const char *rotuloPorta;        // 'E', 'D', 'V' ou PORTA_NUMERADA
+    int totalPistas;                // Textos de pista distintos (pistas coletáveis)
+    const int *pistaDaSala;         // Número da pista de cada sala (-1 se não há)
+    const int *inicioSalasPista;    // Salas da pista c em [inicioSalasPista[c],
+    const int *salasPista;          //   inicioSalasPista[c + 1]) de salasPista
+    void *memoriaPistas;            // Bloco de numerarPistas
+    IndiceSalas indice;             // Nome -> sala, usado pelo goto
+    void *memoria;                  // Vetores de uma mansão carregada (NULL na padrão)
+    char *dados;                    // Arquivo mapeado; nomes e pistas apontam para cá
+    size_t tamanho;                 // Bytes mapeados
+    QuadroEvidencias quadro;        // Montado em montarQuadroEvidencias
+    ArvoreRotas rotas;              // Montada em montarArvoreRotas
+} GrafoMansao;
+
+// Melhor caminho descendo de cada sala da árvore de rotas, contra um suspeito
+typedef struct {
+    int suspeito;
+    long long *ganho;               // Peso da pista de cada sala contra o suspeito
+    long long *melhor;              // Maior soma de ganhos de um caminho que desce da sala
+    int *seguinte;                  // Filho que continua esse caminho (-1: parar aqui)
+    void *memoria;                  // NULL enquanto o plano não foi calculado
+} PlanoSuspeito;
+
+// Entrada do heap do Dijkstra
+typedef struct {
+    long long distancia;
+    int sala;
+} EntradaHeap;
+
+// Percurso pelas rotas mais curtas a partir de uma sala. Os vetores por
+// sala são alocados no primeiro percurso e reaproveitados pelos seguintes:
+// uma sala só vale no percurso atual se a sua visita for a época dele
+typedef struct {
+    const GrafoMansao *mansao;
+    void *memoria;                  // Bloco dos vetores por sala (NULL: ainda não alocado)
+    long long *distancia;           // Custo da rota mais curta até a sala
+    int *anterior;                  // Sala de onde se chega pela rota mais curta
+    int *porta;                     // Porta (posição em destinoPorta) usada para chegar
+    unsigned int *visita;           // Época do último percurso que alcançou a sala
+    unsigned int epoca;             // Época do percurso atual
+    int *fila;                      // Busca em largura: salas na ordem de visita
+    int inicioFila;
+    int fimFila;
+    EntradaHeap *heap;              // Dijkstra: candidatas, a mais próxima na raiz
+    int totalHeap;
+    int capacidadeHeap;
+} Percurso;
+
+// Versões do diário: versoes[0] é o diário inicial e cada pista nova
+// acrescenta uma versão, que compartilha os nós das anteriores. Nenhuma
+// versão é descartada durante a exploração: os vetores locais são
+// trocados por um bloco alocado quando enchem, como na trilha. As pistas
+// do diário atual são as das versões 1 a total - 1, e idsPista as guarda
+// em um vetor contíguo para a pontuação
+typedef struct {
+    PistaNode **versoes;            // versoesLocal ou alocado
+    const char **pistas;            // Pista que originou cada versão
+    int *idsPista;                  // Id da pista no catálogo (-1: fora dele)
+    int *salas;                     // Sala onde a pista foi coletada
+    int total;
+    int capacidade;
+    void *memoria;                  // Bloco com os quatro vetores (NULL: locais)
+    PistaNode *versoesLocal[MAX_VERSOES];
+    const char *pistasLocal[MAX_VERSOES];
+    int idsPistaLocal[MAX_VERSOES];
+    int salasLocal[MAX_VERSOES];
+} HistoricoDiario;
+
+// O que já se sabe de cada sala na sessão
+enum {
+    SALA_NAO_VISITADA = 0,
+    SALA_SEM_PISTA,                 // Visitada, não tem pista
+    SALA_PISTA_COLETADA             // Visitada, pista já está no diário
+};
+
+// Trilha de migalhas: salas do caminho desde a entrada até a atual. Cresce
+// com a profundidade (cada sala aparece no máximo uma vez, então nunca
+// passa do total de salas); naTrilha diz, sem percorrê-la, se uma sala já
+// está nela
+typedef struct {
+    int *salas;                     // salasLocal ou alocado
+    int total;                      // salas[total - 1] é a sala atual
+    int capacidade;
+    unsigned char *naTrilha;        // Um por sala: 1 se a sala está em salas
+    int salasLocal[MAX_TRILHA];
+} Trilha;
+
+// Entrada padrão lida em blocos, sem passar pelo stdio
+typedef struct {
+    char dados[TAMANHO_ENTRADA];
+    size_t inicio;                  // Primeiro byte ainda não consumido
+    size_t fim;                     // Fim dos bytes lidos
+    int fimArquivo;                 // 1 quando read() sinalizou o fim
+} LeitorEntrada;
+
+// Movimento pela porta numerada de índice i (0 = primeira porta da sala).
+// Os demais movimentos são o próprio caractere do comando.
+#define MOVIMENTO_PORTA(i) (256 + (i))
+#define EH_MOVIMENTO_PORTA(movimento) ((movimento) >= 256)
+
+// Fila circular de movimentos (E, D, S, portas...) aguardando execução.
+// Uma linha digitada cabe no vetor local; a rota de um goto pode ter
+// tantos movimentos quanto a mansão tem salas e faz a fila crescer
+typedef struct {
+    int *movimentos;                // movimentosLocal ou alocado
+    int inicio;
+    int total;
+    int capacidade;
+    int movimentosLocal[MAX_MOVIMENTOS];
+} FilaMovimentos;
+
+// Destino do texto de uma partida: um FILE (modo local) ou um buffer
+// que o servidor esvazia no socket
+typedef struct {
+    FILE *arquivo;                  // NULL: acumula em dados
+    char *dados;
+    size_t tamanho;
+    size_t capacidade;
+    int descartar;                  // 1: o texto é ignorado (repetição de registros)
+} Saida;
+
+// Bytes de um registro binário em montagem
+typedef struct {
+    unsigned char *dados;
+    size_t tamanho;
+    size_t capacidade;
+} BufferRegistro;
+
+// Nomes de acusados de um arquivo de registro: o id é a posição em textos
+typedef struct {
+    IndiceNomes indice;             // Nome -> id (só na gravação)
+    char **textos;
+    int total;
+    int capacidade;
+} NomesRegistro;
+
+// Arquivo de registro das partidas (--gravar), compartilhado pelas sessões
+typedef struct {
+    FILE *arquivo;
+    NomesRegistro nomes;
+    unsigned long partidas;
+} Gravador;
+
+typedef enum {
+    FASE_EXPLORANDO,                // Aguardando movimentos
+    FASE_ACUSANDO,                  // Aguardando o nome do acusado
+    FASE_ENCERRADA
+} FaseSessao;
+
+// Estado de uma partida. Avança a cada linha recebida e nunca espera
+// pela entrada: o modo local e o servidor usam o mesmo código. Mansão e
+// tabela hash são compartilhadas, somente leitura.
+typedef struct {
+    const TabelaHash *hash;
+    const GrafoMansao *mansao;
+    Saida *saida;
+    FaseSessao fase;
+    int salaAtual;
+    int entrouNaSala;               // 1 se a sala atual ainda não foi descrita
+    FilaMovimentos fila;
+    Trilha trilha;
+    HistoricoDiario historico;      // Diário durante a exploração
+    PistaNode *arvorePistas;        // Diário final, na fase de acusação
+    unsigned char *estadoSalas;     // Um por sala: estadoSalasLocal ou alocado
+    unsigned char estadoSalasLocal[2 * MAX_SALAS]; // Estados e, em seguida, trilha.naTrilha
+    uint64_t pistasColetadas[PALAVRAS_QUADRO]; // Diário atual como conjunto de bits
+    PlanoSuspeito dica;             // Plano do comando H, mantido a cada pista
+    Percurso percurso;              // Rotas de goto e P, reaproveitadas
+    Gravador *gravador;             // NULL: a partida não é gravada
+    BufferRegistro registro;        // Tokens gravados da partida
+    uint64_t resumo;                // Resumo dos resultados, comparado na repetição
+} Sessao;
+
+// Faixas dos acontecimentos no resumo: entrada numa sala (id da sala),
+// pista coletada e pista desfeita (tamanho do diário depois dela)
+#define RESUMO_COLETA   (1ULL << 32)
+#define RESUMO_DESFEITA (2ULL << 32)
+
+// Acrescenta um acontecimento da partida ao resumo (FNV-1a)
+static inline void misturarResumo(Sessao *sessao, uint64_t valor) {
+    sessao->resumo = (sessao->resumo ^ valor) * 0x100000001b3ULL;
+}
+
+// Liga ou desliga no conjunto da sessão a pista coletável da sala
+static inline void marcarPistaColetada(Sessao *sessao, int sala, int coletada) {
+    const QuadroEvidencias *quadro = &sessao->mansao->quadro;
+    if (quadro->ativo) {
+        int pista = sessao->mansao->pistaDaSala[sala];
+        uint64_t bit = 1ULL << (pista & 63);
+        if (coletada) {
+            sessao->pistasColetadas[pista >> 6] |= bit;
+        } else {
+            sessao->pistasColetadas[pista >> 6] &= ~bit;
+        }
+    }
+}
+
+/*
+ * Instrumentação de desempenho
+ * Compile com -DPERFIL para medir as funções do caminho crítico. Sem a
+ * flag, as macros abaixo ficam vazias e não geram nenhum código.
+ * Ao final da sessão o relatório em JSON vai para o arquivo indicado na
+ * variável de ambiente PERFIL_ARQUIVO (padrão: perfil.json).
+ */
+#ifdef PERFIL
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define UNIDADE_PERFIL "ciclos"
+#else
+#include <time.h>
+#define UNIDADE_PERFIL "ns"
+#endif
+
+#define SUBFAIXAS_PERFIL 8            // Faixas por potência de 2 no histograma
+#define FAIXAS_PERFIL (64 * SUBFAIXAS_PERFIL)
+
+// Funções medidas
+enum {
+    PERFIL_EXPLORAR_SALAS,
+    PERFIL_INSERIR_PISTA,
+    PERFIL_INSERIR_NA_HASH,
+    PERFIL_BUSCAR_ID_PISTA,
+    PERFIL_ENCONTRAR_SUSPEITO,
+    PERFIL_FUNCAO_HASH,
+    PERFIL_CALCULAR_PONTUACOES,
+    PERFIL_PONTUAR_SUSPEITOS,
+    PERFIL_CONTAR_PISTAS,
+    PERFIL_LIBERAR_PISTAS,
+    PERFIL_LIBERAR_HASH,
+    PERFIL_CARREGAR_CATALOGO,
+    TOTAL_FUNCOES_PERFIL
+};
+
+static const char *nomesPerfil[TOTAL_FUNCOES_PERFIL] = {
+    "explorarSalas", "inserirPista", "inserirNaHash", "buscarIdPista",
+    "encontrarSuspeito", "funcaoHash", "calcularPontuacoes",
+    "pontuarSuspeitos", "contarPistasPorSuspeito", "liberarArvorePistas", "liberarHash",
+    "carregarCatalogo",
+};
+
+// Estatísticas acumuladas de uma função
+typedef struct {
+    unsigned long long chamadas;
+    unsigned long long alocacoes;
+    unsigned long long liberacoes;
+    unsigned long long total;       // Soma das durações
+    unsigned long long minimo;
+    unsigned long long maximo;
+    int profundidade;               // Chamadas recursivas em andamento
+    unsigned long long histograma[FAIXAS_PERFIL];
+} EstatisticaPerfil;
+
+// Medição em andamento, encerrada ao sair do escopo da função
+typedef struct {
+    int funcao;
+    unsigned long long inicio;
+} MarcaPerfil;
+
+static EstatisticaPerfil perfil[TOTAL_FUNCOES_PERFIL];
+
+// Filtro de Bloom da tabela usada na partida, copiado antes de liberá-la
+static struct {
+    int registrado;
+    EstatisticasFiltro contadores;
+    unsigned int bits;
+    double taxaObservada;
+    double taxaEstimada;
+} filtroPerfil;
+
+static inline unsigned long long lerRelogioPerfil(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+    return (unsigned long long)agora.tv_sec * 1000000000ULL + (unsigned long long)agora.tv_nsec;
+#endif
+}
+
+// Faixa log-linear do histograma: potência de 2 e os 3 bits seguintes
+static int faixaPerfil(unsigned long long duracao) {
+    if (duracao < SUBFAIXAS_PERFIL) {
+        return (int)duracao;
+    }
+    int expoente = 63 - __builtin_clzll(duracao);
+    int sub = (int)((duracao >> (expoente - 3)) & (SUBFAIXAS_PERFIL - 1));
+    return (expoente - 2) * SUBFAIXAS_PERFIL + sub;
+}
+
+// Maior duração que cai na faixa informada
+static unsigned long long limiteFaixaPerfil(int faixa) {
+    if (faixa < SUBFAIXAS_PERFIL) {
+        return (unsigned long long)faixa;
+    }
+    int expoente = faixa / SUBFAIXAS_PERFIL + 2;
+    unsigned long long base = 1ULL << expoente;
+    unsigned long long passo = base / SUBFAIXAS_PERFIL;
+    return base + passo * (unsigned long long)(faixa % SUBFAIXAS_PERFIL + 1) - 1;
+}
+
+static inline MarcaPerfil entrarPerfil(int funcao) {
+    MarcaPerfil marca = { funcao, 0 };
+    // Só a chamada mais externa de uma recursão é medida
+    if (perfil[funcao].profundidade++ == 0) {
+        marca.inicio = lerRelogioPerfil();
+    }
+    return marca;
+}
+
+static inline void sairPerfil(MarcaPerfil *marca) {
+    EstatisticaPerfil *e = &perfil[marca->funcao];
+    if (--e->profundidade > 0) {
+        return;
+    }
+    unsigned long long duracao = lerRelogioPerfil() - marca->inicio;
+    if (e->chamadas == 0 || duracao < e->minimo) {
+        e->minimo = duracao;
+    }
+    if (duracao > e->maximo) {
+        e->maximo = duracao;
+    }
+    e->chamadas++;
+    e->total += duracao;
+    e->histograma[faixaPerfil(duracao)]++;
+}
+
+// Percentil aproximado pelo limite superior da faixa do histograma
+static unsigned long long percentilPerfil(const EstatisticaPerfil *e, double fracao) {
+    // Posição (1..chamadas) da amostra do percentil, arredondada para cima
+    unsigned long long alvo = (unsigned long long)(fracao * (double)e->chamadas);
+    if ((double)alvo < fracao * (double)e->chamadas || alvo == 0) {
+        alvo++;
+    }
+    unsigned long long acumulado = 0;
+    for (int f = 0; f < FAIXAS_PERFIL; f++) {
+        acumulado += e->histograma[f];
+        if (acumulado >= alvo) {
+            unsigned long long limite = limiteFaixaPerfil(f);
+            return limite < e->maximo ? limite : e->maximo;
+        }
+    }
+    return e->maximo;
+}
+
+static void gravarRelatorioPerfil(void) {
+    const char *caminho = getenv("PERFIL_ARQUIVO");
+    FILE *arquivo = fopen(caminho != NULL ? caminho : "perfil.json", "w");
+    if (arquivo == NULL) {
+        return;
+    }
+    
+    fprintf(arquivo, "{\n  \"unidade\": \"%s\",\n  \"funcoes\": [\n", UNIDADE_PERFIL);
+    for (int i = 0; i < TOTAL_FUNCOES_PERFIL; i++) {
+        const EstatisticaPerfil *e = &perfil[i];
+        fprintf(arquivo, "    {\"funcao\": \"%s\", \"chamadas\": %llu, \"alocacoes\": %llu, "
+                "\"liberacoes\": %llu, \"total\": %llu",
+                nomesPerfil[i], e->chamadas, e->alocacoes, e->liberacoes, e->total);
+        if (e->chamadas > 0) {
+            fprintf(arquivo, ", \"media\": %llu, \"min\": %llu, \"p50\": %llu, \"p99\": %llu, \"max\": %llu",
+                    e->total / e->chamadas, e->minimo, percentilPerfil(e, 0.50),
+                    percentilPerfil(e, 0.99), e->maximo);
+        }
+        
+        // Histograma esparso: [limite superior da faixa, contagem]
+        fprintf(arquivo, ", \"histograma\": [");
+        int primeira = 1;
+        for (int f = 0; f < FAIXAS_PERFIL; f++) {
+            if (e->histograma[f] > 0) {
+                fprintf(arquivo, "%s[%llu, %llu]", primeira ? "" : ", ",
+                        limiteFaixaPerfil(f), e->histograma[f]);
+                primeira = 0;
+            }
+        }
+        fprintf(arquivo, "]}%s\n", i + 1 < TOTAL_FUNCOES_PERFIL ? "," : "");
+    }
+    fprintf(arquivo, "  ]");
+    if (filtroPerfil.registrado) {
+        fprintf(arquivo, ",\n  \"filtro\": {\"bits\": %u, \"consultas\": %llu, \"rejeitadas\": %llu, "
+                "\"falsosPositivos\": %llu, \"taxaFalsoPositivo\": %.6f, \"taxaEstimada\": %.6f}",
+                filtroPerfil.bits, filtroPerfil.contadores.consultas, filtroPerfil.contadores.rejeitadas,
+                filtroPerfil.contadores.falsosPositivos, filtroPerfil.taxaObservada,
+                filtroPerfil.taxaEstimada);
+    }
+    fprintf(arquivo, "\n}\n");
+    fclose(arquivo);
+}
+
+#define PERFIL_MEDIR(funcao) \
+    MarcaPerfil marcaPerfil_ __attribute__((cleanup(sairPerfil))) = entrarPerfil(funcao)
+#define PERFIL_ALOCACAO(funcao) (perfil[funcao].alocacoes++)
+#define PERFIL_LIBERACAO(funcao, quantidade) (perfil[funcao].liberacoes += (quantidade))
+#define PERFIL_INICIAR() atexit(gravarRelatorioPerfil)
+#define PERFIL_FILTRO(hash)                                                   \
+    (filtroPerfil.registrado = 1,                                             \
+     filtroPerfil.contadores = *(hash)->estatisticasFiltro,                   \
+     filtroPerfil.bits = (hash)->blocosFiltro * PALAVRAS_BLOCO_FILTRO * 64,   \
+     filtroPerfil.taxaObservada = taxaFalsoPositivoFiltro(hash),              \
+     filtroPerfil.taxaEstimada = estimarFalsoPositivoFiltro(hash))
+
+#else
+
+#define PERFIL_MEDIR(funcao)
+#define PERFIL_ALOCACAO(funcao)
+#define PERFIL_LIBERACAO(funcao, quantidade) ((void)(quantidade))
+#define PERFIL_INICIAR()
+#define PERFIL_FILTRO(hash)
+
+#endif
+
+/*
+ * Função: funcaoHash
+ * Descrição: Calcula o hash de uma string (pista); o índice reduz o valor
+ *            à quantidade de baldes da tabela
+ * Parâmetros:
+ *   - chave: string da pista
+ * Retorno: valor hash
+ */
+unsigned int funcaoHash(const char *chave) {
+    PERFIL_MEDIR(PERFIL_FUNCAO_HASH);
+    return hashTexto(chave);
+}
+
+/*
+ * Função: alocarFiltro
+ * Descrição: Aloca o filtro de Bloom vazio de uma tabela, com os
+ *            contadores logo após os blocos (mesma alocação)
+ * Parâmetros:
+ *   - hash: ponteiro para a tabela hash
+ *   - capacidadePistas: pistas que o filtro deve comportar
+ * Retorno: void
+ */
+void alocarFiltro(TabelaHash *hash, int capacidadePistas) {
+    unsigned int blocos = blocosFiltroPara(capacidadePistas);
+    size_t bytesFiltro = (size_t)blocos * PALAVRAS_BLOCO_FILTRO * sizeof(uint64_t);
+    size_t bytes = bytesFiltro + sizeof(EstatisticasFiltro);
+    
+    // Blocos alinhados à linha de cache (aligned_alloc exige múltiplo de 64)
+    uint64_t *filtro = (uint64_t*)aligned_alloc(64, (bytes + 63) / 64 * 64);
+    if (filtro == NULL) {
+        printf("Erro ao alocar memória para o filtro!\n");
+        exit(1);
+    }
+    memset(filtro, 0, bytes);
+    hash->filtro = filtro;
+    hash->blocosFiltro = blocos;
+    hash->estatisticasFiltro = (EstatisticasFiltro*)((char*)filtro + bytesFiltro);
+}
+
+/*
+ * Função: reconstruirFiltro
+ * Descrição: Refaz o filtro de Bloom a partir das pistas do índice
+ *            (usado no catálogo padrão, cujo filtro não cabe em um
+ *            inicializador estático)
+ * Parâmetros:
+ *   - hash: ponteiro para a tabela hash
+ * Retorno: void
+ */
+void reconstruirFiltro(const TabelaHash *hash) {
+    memset(hash->filtro, 0, (size_t)hash->blocosFiltro * PALAVRAS_BLOCO_FILTRO * sizeof(uint64_t));
+    for (unsigned int b = 0; b < hash->indice.totalBaldes; b++) {
+        for (const HashNode *no = hash->indice.baldes[b]; no != NULL; no = no->proximo) {
+            adicionarAoFiltro(hash->filtro, hash->blocosFiltro, no->pista);
+        }
+    }
+}
+
+/*
+ * Função: taxaFalsoPositivoFiltro
+ * Descrição: Fração das consultas a pistas ausentes que o filtro deixou
+ *            passar até os baldes (taxa observada de falsos positivos)
+ * Parâmetros:
+ *   - hash: ponteiro para a tabela hash
+ * Retorno: taxa entre 0 e 1 (0 se nenhuma pista ausente foi consultada)
+ */
+double taxaFalsoPositivoFiltro(const TabelaHash *hash) {
+    const EstatisticasFiltro *e = hash->estatisticasFiltro;
+    unsigned long long ausentes = e->rejeitadas + e->falsosPositivos;
+    
+    return ausentes > 0 ? (double)e->falsosPositivos / (double)ausentes : 0.0;
+}
+
+/*
+ * Função: estimarFalsoPositivoFiltro
+ * Descrição: Estima a taxa de falsos positivos pela ocupação do filtro:
+ *            média, por bloco, de (bits ligados / 512) ^ FUNCOES_FILTRO
+ * Parâmetros:
+ *   - hash: ponteiro para a tabela hash
+ * Retorno: taxa estimada entre 0 e 1
+ */
+double estimarFalsoPositivoFiltro(const TabelaHash *hash) {
+    double soma = 0.0;
+    
+    for (unsigned int b = 0; b < hash->blocosFiltro; b++) {
+        const uint64_t *bloco = hash->filtro + (size_t)b * PALAVRAS_BLOCO_FILTRO;
+        int ligados = 0;
+        for (int w = 0; w < PALAVRAS_BLOCO_FILTRO; w++) {
+            ligados += __builtin_popcountll(bloco[w]);
+        }
+        double ocupacao = ligados / (PALAVRAS_BLOCO_FILTRO * 64.0);
+        double taxa = 1.0;
+        for (int i = 0; i < FUNCOES_FILTRO; i++) {
+            taxa *= ocupacao;
+        }
+        soma += taxa;
+    }
+    return soma / hash->blocosFiltro;
+}
+
+/*
+ * Função: inicializarHash
+ * Descrição: Inicializa a tabela hash vazia, sem pistas nem suspeitos.
+ *            Todos os vetores ficam em um único bloco alocado aqui.
+ * Parâmetros:
+ *   - hash: ponteiro para a tabela hash
+ *   - capacidadePistas: máximo de pistas distintas
+ *   - capacidadeSuspeitos: máximo de suspeitos distintos
+ *   - capacidadeEvidencias: máximo de associações pista-suspeito
+ * Retorno: void
+ */
+void inicializarHash(TabelaHash *hash, int capacidadePistas, int capacidadeSuspeitos,
+                     int capacidadeEvidencias) {
+    size_t bytes = sizeof(Evidencia) * (size_t)capacidadeEvidencias
+                 + sizeof(int) * ((size_t)capacidadePistas + 1 + 2 * (size_t)capacidadeEvidencias)
+                 + (sizeof(const char*) + TAMANHO_NOME) * (size_t)capacidadeSuspeitos;
+    char *bloco = (char*)malloc(bytes);
+    if (bloco == NULL) {
+        printf("Erro ao alocar memória para hash!\n");
+        exit(1);
+    }
+    
+    // Vetores em ordem decrescente de alinhamento; os nomes vão no fim
+    hash->memoria = bloco;
+    hash->evidencias = (Evidencia*)bloco;
+    hash->suspeitos = (const char**)(hash->evidencias + capacidadeEvidencias);
+    hash->inicioPista = (int*)(hash->suspeitos + capacidadeSuspeitos);
+    hash->suspeitoEvidencia = hash->inicioPista + capacidadePistas + 1;
+    hash->pesoEvidencia = hash->suspeitoEvidencia + capacidadeEvidencias;
+    char *nomes = (char*)(hash->pesoEvidencia + capacidadeEvidencias);
+    for (int i = 0; i < capacidadeSuspeitos; i++) {
+        hash->suspeitos[i] = nomes + (size_t)i * TAMANHO_NOME;
+    }
+    
+    indice_inicializar(&hash->indice, TAMANHO_HASH);
+    alocarFiltro(hash, capacidadePistas);
+    hash->totalPistas = 0;
+    hash->capacidadePistas = capacidadePistas;
+    hash->totalSuspeitos = 0;
+    hash->capacidadeSuspeitos = capacidadeSuspeitos;
+    hash->totalEvidencias = 0;
+    hash->capacidadeEvidencias = capacidadeEvidencias;
+    hash->inicioPista[0] = 0;
+    hash->compactada = 1;
+    hash->arquivo = (CatalogoArquivo){ NULL, 0, NULL };
+}
+
+/*
+ * Função: buscarIdPista
+ * Descrição: Busca o id numérico de uma pista na tabela hash. O filtro de
+ *            Bloom descarta a maioria das pistas ausentes antes dos baldes.
+ * Parâmetros:
+ *   - hash: ponteiro para a tabela hash
+ *   - pista: string da pista a ser buscada
+ * Retorno: id da pista (ou -1 se não encontrada)
+ */
+int buscarIdPista(const TabelaHash *hash, const char *pista) {
+    PERFIL_MEDIR(PERFIL_BUSCAR_ID_PISTA);
+    EstatisticasFiltro *estatisticas = hash->estatisticasFiltro;
+    
+    estatisticas->consultas++;
+    if (!filtroPodeConter(hash->filtro, hash->blocosFiltro, pista)) {
+        estatisticas->rejeitadas++;
+        return -1;
+    }
+    
+    const HashNode *no = indice_buscar(&hash->indice, pista);
+    if (no == NULL) {
+        estatisticas->falsosPositivos++;
+        return -1;  // -1: pista não encontrada
+    }
+    return no->idPista;
+}
+
+/*
+ * Função: localizarIdPista
+ * Descrição: Igual a buscarIdPista, mas sem contar a consulta nas
+ *            estatísticas do filtro. Usada na carga do catálogo e na
+ *            montagem da mansão, para que as estatísticas reflitam só
+ *            as consultas da partida.
+ * Parâmetros:
+ *   - hash: ponteiro para a tabela hash
+ *   - pista: string da pista a ser buscada
+ * Retorno: id da pista (ou -1 se não encontrada)
+ */
+int localizarIdPista(const TabelaHash *hash, const char *pista) {
+    if (!filtroPodeConter(hash->filtro, hash->blocosFiltro, pista)) {
+        return -1;
+    }
+    const HashNode *no = indice_buscar(&hash->indice, pista);
+    return no != NULL ? no->idPista : -1;
+}
+
+/*
+ * Função: buscarIdSuspeito
+ * Descrição: Busca o id numérico de um suspeito pelo nome
+ * Parâmetros:
+ *   - hash: ponteiro para a tabela hash
+ *   - nome: nome do suspeito
+ * Retorno: id do suspeito (ou -1 se não cadastrado)
+ */
+int buscarIdSuspeito(const TabelaHash *hash, const char *nome) {
+    for (int i = 0; i < hash->totalSuspeitos; i++) {
+        if (strcmp(hash->suspeitos[i], nome) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
 
-// Estrutura que representa cada sala da mansão
-typedef struct Sala {
-    char nome[50];                  // Nome do cômodo
-    struct Sala *esquerda;          // Sala à esquerda
-    struct Sala *direita;           // Sala à direita
-} Sala;
+/*
+ * Função: inserirNaHashComPeso
+ * Descrição: Registra que uma pista incrimina um suspeito com um dado peso.
+ *            Uma mesma pista pode ser associada a vários suspeitos.
+ *            A matriz de evidências só é atualizada por compactarEvidencias.
+ * Parâmetros:
+ *   - hash: ponteiro para a tabela hash
+ *   - pista: string da pista (chave)
+ *   - suspeito: string do nome do suspeito
+ *   - peso: força da evidência contra o suspeito
+ * Retorno: void
+ */
+void inserirNaHashComPeso(TabelaHash *hash, const char *pista, const char *suspeito, int peso) {
+    PERFIL_MEDIR(PERFIL_INSERIR_NA_HASH);
+    
+    if (hash->totalEvidencias >= hash->capacidadeEvidencias) {
+        printf("Erro: limite de evidências atingido!\n");
+        exit(1);
+    }
+    
+    int idPista = localizarIdPista(hash, pista);
+    if (idPista < 0) {
+        if (hash->totalPistas >= hash->capacidadePistas) {
+            printf("Erro: limite de pistas atingido!\n");
+            exit(1);
+        }
+        
+        // Cria novo nó no balde da pista
+        HashNode *novoNo = indice_inserir(&hash->indice, pista);
+        PERFIL_ALOCACAO(PERFIL_INSERIR_NA_HASH);
+        adicionarAoFiltro(hash->filtro, hash->blocosFiltro, novoNo->pista);
+        idPista = hash->totalPistas++;
+        novoNo->idPista = idPista;
+    }
+    
+    int idSuspeito = buscarIdSuspeito(hash, suspeito);
+    if (idSuspeito < 0) {
+        if (hash->totalSuspeitos >= hash->capacidadeSuspeitos) {
+            printf("Erro: limite de suspeitos atingido!\n");
+            exit(1);
+        }
+        if (strlen(suspeito) >= TAMANHO_NOME) {
+            printf("Erro: nome de suspeito muito longo!\n");
+            exit(1);
+        }
+        idSuspeito = hash->totalSuspeitos++;
+        strcpy((char*)hash->suspeitos[idSuspeito], suspeito);
+    }
+    
+    Evidencia *nova = &hash->evidencias[hash->totalEvidencias++];
+    nova->idPista = idPista;
+    nova->idSuspeito = idSuspeito;
+    nova->peso = peso;
+    hash->compactada = 0;
+}
+
+/*
+ * Função: inserirNaHash
+ * Descrição: Insere uma associação pista-suspeito com peso 1
+ * Parâmetros:
+ *   - hash: ponteiro para a tabela hash
+ *   - pista: string da pista (chave)
+ *   - suspeito: string do nome do suspeito (valor)
+ * Retorno: void
+ */
+void inserirNaHash(TabelaHash *hash, const char *pista, const char *suspeito) {
+    inserirNaHashComPeso(hash, pista, suspeito, 1);
+}
+
+/*
+ * Função: compactarEvidencias
+ * Descrição: Reconstrói a matriz CSR a partir das evidências inseridas
+ *            (ordenação por contagem, O(pistas + evidências))
+ * Parâmetros:
+ *   - hash: ponteiro para a tabela hash
+ * Retorno: void
+ */
+void compactarEvidencias(TabelaHash *hash) {
+    int *inicio = hash->inicioPista;
+    
+    // Conta as evidências de cada pista, deslocadas em uma posição
+    for (int p = 0; p <= hash->totalPistas; p++) {
+        inicio[p] = 0;
+    }
+    for (int i = 0; i < hash->totalEvidencias; i++) {
+        inicio[hash->evidencias[i].idPista + 1]++;
+    }
+    
+    // Soma prefixada: inicio[p] passa a ser o começo da linha p
+    for (int p = 0; p < hash->totalPistas; p++) {
+        inicio[p + 1] += inicio[p];
+    }
+    
+    // Distribui as evidências; inicio[p] avança até o começo da linha p + 1
+    for (int i = 0; i < hash->totalEvidencias; i++) {
+        const Evidencia *e = &hash->evidencias[i];
+        int posicao = inicio[e->idPista]++;
+        hash->suspeitoEvidencia[posicao] = e->idSuspeito;
+        hash->pesoEvidencia[posicao] = e->peso;
+    }
+    
+    // Restaura os começos de linha
+    for (int p = hash->totalPistas; p > 0; p--) {
+        inicio[p] = inicio[p - 1];
+    }
+    inicio[0] = 0;
+    
+    hash->compactada = 1;
+}
+
+/*
+ * Função: encontrarSuspeito
+ * Descrição: Busca o principal suspeito (maior peso) associado a uma pista
+ * Parâmetros:
+ *   - hash: ponteiro para a tabela hash (compactada)
+ *   - pista: string da pista a ser buscada
+ * Retorno: ponteiro para string com nome do suspeito (ou NULL se não encontrado)
+ */
+const char* encontrarSuspeito(const TabelaHash *hash, const char *pista) {
+    PERFIL_MEDIR(PERFIL_ENCONTRAR_SUSPEITO);
+    int idPista = buscarIdPista(hash, pista);
+    if (idPista < 0) {
+        return NULL;  // Pista não encontrada
+    }
+    
+    int melhor = -1;
+    for (int k = hash->inicioPista[idPista]; k < hash->inicioPista[idPista + 1]; k++) {
+        if (melhor < 0 || hash->pesoEvidencia[k] > hash->pesoEvidencia[melhor]) {
+            melhor = k;
+        }
+    }
+    
+    return melhor < 0 ? NULL : hash->suspeitos[hash->suspeitoEvidencia[melhor]];
+}
+
+/*
+ * Carga de catálogos
+ * Um catálogo é um arquivo texto com uma associação por linha:
+ *     pista<SEP>suspeito[<SEP>peso]
+ * O separador é TAB (TSV) se a primeira linha tiver um, senão vírgula
+ * (CSV simples, sem aspas). Linhas vazias e iniciadas por # são ignoradas.
+ *
+ * O arquivo é mapeado em memória e os campos são terminados no próprio
+ * mapeamento: pistas e nomes apontam para ele, sem cópias. A carga roda
+ * em etapas paralelas, sem travas:
+ *   1. cada thread conta as linhas do seu trecho do arquivo;
+ *   2. cada thread separa os campos do trecho, numera os suspeitos do
+ *      trecho e conta as associações de cada partição (partição = balde
+ *      do índice módulo o número de threads);
+ *   3. os suspeitos recebem ids globais (etapa serial e curta) e as
+ *      associações são agrupadas por partição, na ordem do arquivo;
+ *   4. cada thread insere no índice as pistas da sua partição, cujos
+ *      baldes nenhuma outra thread toca;
+ *   5. cada thread copia os nós da sua partição para o bloco definitivo,
+ *      com uma posição por pista distinta, e os acrescenta ao filtro;
+ *   6. cada thread resume as associações da partição (pista, suspeito e
+ *      peso) no bloco dos nós provisórios, e as linhas são soltas;
+ *   7. cada thread monta as linhas do CSR das pistas da sua partição.
+ * Os nós do índice saem de um único bloco: não há malloc por linha. O
+ * estado da carga é do chamador, e duas cargas podem rodar ao mesmo tempo.
+ */
+
+#define BALDES_SUSPEITOS 64          // Baldes das tabelas de suspeitos da carga
+
+// Associação lida do arquivo, enquanto a carga está em andamento
+typedef struct {
+    const char *pista;
+    unsigned int balde;             // Balde da pista no índice
+    int idSuspeito;                 // Id no trecho até a etapa 3, depois global
+    int idPista;                    // Id da pista na partição (etapa 4)
+    int peso;
+} LinhaCatalogo;
+
+// Associação resumida para a montagem do CSR, depois que as linhas são soltas
+typedef struct {
+    int idPista;                    // Id na partição
+    int idSuspeito;
+    int peso;
+} AssociacaoCarga;
+_Static_assert(sizeof(AssociacaoCarga) <= sizeof(HashNode), "associação maior que o nó provisório");
+
+typedef struct CargaCatalogo CargaCatalogo;
+
+// Trabalho de uma thread: um trecho do arquivo e uma partição do índice
+typedef struct {
+    CargaCatalogo *carga;
+    int indice;                     // Número do trecho e da partição
+    char *inicio;                   // Trecho do arquivo [inicio, fim)
+    char *fim;
+    int primeiraLinha;              // Posição do trecho em linhas[]
+    int totalLinhas;                // Linhas do trecho; depois, associações
+    int particao[MAX_THREADS_CARGA]; // Associações por partição; na etapa 3,
+                                    // próxima posição de cada partição em ordem[]
+    IndiceNomes suspeitosTrecho;
+    const char **nomesTrecho;       // Suspeitos do trecho, pelo id no trecho
+    int totalNomes;
+    int capacidadeNomes;
+    int *traducao;                  // Id no trecho -> id global do suspeito
+    int linhaErro;                  // Número da primeira linha malformada (0: nenhuma)
+    int pistasParticao;             // Pistas distintas da partição
+} TrabalhoCarga;
+
+struct CargaCatalogo {
+    TabelaHash *hash;
+    char separador;
+    int totalThreads;
+    LinhaCatalogo *linhas;
+    int *ordem;                     // Índices de linhas[] agrupados por partição
+    HashNode *nosCarga;             // Nós provisórios do índice, um por associação
+    AssociacaoCarga *associacoes;   // O mesmo bloco, reusado a partir da etapa 6
+    int inicioParticao[MAX_THREADS_CARGA + 1]; // Faixa de cada partição em ordem[]
+    int primeiraPista[MAX_THREADS_CARGA];      // Id global da 1ª pista da partição
+    TrabalhoCarga trabalhos[MAX_THREADS_CARGA];
+};
+
+/*
+ * Função: executarEtapa
+ * Descrição: Roda uma etapa da carga em todas as threads (a primeira na
+ *            thread atual) e espera todas terminarem
+ */
+static void executarEtapa(CargaCatalogo *carga, void *(*etapa)(void*)) {
+    pthread_t threads[MAX_THREADS_CARGA];
+    
+    for (int t = 1; t < carga->totalThreads; t++) {
+        if (pthread_create(&threads[t], NULL, etapa, &carga->trabalhos[t]) != 0) {
+            printf("Erro ao criar thread de carga!\n");
+            exit(1);
+        }
+    }
+    etapa(&carga->trabalhos[0]);
+    for (int t = 1; t < carga->totalThreads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+// Etapa 1: conta as linhas do trecho
+static void *contarLinhasTrecho(void *argumento) {
+    TrabalhoCarga *trabalho = (TrabalhoCarga*)argumento;
+    int linhas = 0;
+    
+    for (char *atual = trabalho->inicio; atual < trabalho->fim; linhas++) {
+        char *quebra = (char*)memchr(atual, '\n', (size_t)(trabalho->fim - atual));
+        atual = quebra != NULL ? quebra + 1 : trabalho->fim;
+    }
+    trabalho->totalLinhas = linhas;
+    return NULL;
+}
+
+// Etapa 2: separa os campos de cada linha do trecho e numera os suspeitos
+static void *separarCamposTrecho(void *argumento) {
+    TrabalhoCarga *trabalho = (TrabalhoCarga*)argumento;
+    CargaCatalogo *carga = trabalho->carga;
+    LinhaCatalogo *saida = carga->linhas + trabalho->primeiraLinha;
+    const IndicePistas *indice = &carga->hash->indice;
+    char separador = carga->separador;
+    int total = 0;
+    int numeroLinha = trabalho->primeiraLinha;  // Linhas do arquivo antes do trecho
+    
+    nomes_inicializar(&trabalho->suspeitosTrecho, BALDES_SUSPEITOS);
+    
+    char *linha = trabalho->inicio;
+    while (linha < trabalho->fim) {
+        numeroLinha++;
+        char *fimLinha = (char*)memchr(linha, '\n', (size_t)(trabalho->fim - linha));
+        if (fimLinha == NULL) {
+            fimLinha = trabalho->fim;  // Última linha sem \n: fim aponta o byte reservado
+        }
+        char *proxima = fimLinha + 1;
+        *fimLinha = '\0';
+        if (fimLinha > linha && fimLinha[-1] == '\r') {
+            *--fimLinha = '\0';
+        }
+        
+        if (*linha == '\0' || *linha == '#') {
+            linha = proxima;
+            continue;
+        }
+        
+        char *suspeito = (char*)memchr(linha, separador, (size_t)(fimLinha - linha));
+        if (suspeito == NULL || suspeito == linha || suspeito + 1 == fimLinha) {
+            trabalho->linhaErro = numeroLinha;
+            break;
+        }
+        *suspeito++ = '\0';
+        
+        int peso = 1;
+        char *campoPeso = (char*)memchr(suspeito, separador, (size_t)(fimLinha - suspeito));
+        if (campoPeso != NULL) {
+            *campoPeso++ = '\0';
+            char *resto;
+            long valor = strtol(campoPeso, &resto, 10);
+            if (resto == campoPeso || *resto != '\0' || valor < INT_MIN || valor > INT_MAX) {
+                trabalho->linhaErro = numeroLinha;
+                break;
+            }
+            peso = (int)valor;
+        }
+        
+        // Suspeitos são poucos: cada trecho os numera na ordem em que aparecem
+        const NomeNode *nome = nomes_buscar(&trabalho->suspeitosTrecho, suspeito);
+        if (nome == NULL) {
+            if (trabalho->totalNomes == trabalho->capacidadeNomes) {
+                trabalho->capacidadeNomes = trabalho->capacidadeNomes > 0 ? 2 * trabalho->capacidadeNomes : 16;
+                trabalho->nomesTrecho = (const char**)realloc(trabalho->nomesTrecho,
+                    sizeof(const char*) * (size_t)trabalho->capacidadeNomes);
+                if (trabalho->nomesTrecho == NULL) {
+                    printf("Erro ao alocar memória para suspeitos!\n");
+                    exit(1);
+                }
+            }
+            NomeNode *novo = nomes_inserir(&trabalho->suspeitosTrecho, suspeito);
+            novo->id = trabalho->totalNomes;
+            trabalho->nomesTrecho[trabalho->totalNomes++] = suspeito;
+            nome = novo;
+        }
+        
+        LinhaCatalogo *atual = &saida[total++];
+        atual->pista = linha;
+        atual->balde = hashTexto(linha) % indice->totalBaldes;
+        atual->idSuspeito = nome->id;
+        atual->peso = peso;
+        trabalho->particao[atual->balde % (unsigned int)carga->totalThreads]++;
+        
+        linha = proxima;
+    }
+    
+    trabalho->totalLinhas = total;
+    return NULL;
+}
+
+// Etapa 3: traduz os ids de suspeitos e agrupa as associações por partição
+static void *distribuirLinhasTrecho(void *argumento) {
+    TrabalhoCarga *trabalho = (TrabalhoCarga*)argumento;
+    CargaCatalogo *carga = trabalho->carga;
+    unsigned int particoes = (unsigned int)carga->totalThreads;
+    
+    for (int i = 0; i < trabalho->totalLinhas; i++) {
+        int posicao = trabalho->primeiraLinha + i;
+        LinhaCatalogo *linha = &carga->linhas[posicao];
+        linha->idSuspeito = trabalho->traducao[linha->idSuspeito];
+        carga->ordem[trabalho->particao[linha->balde % particoes]++] = posicao;
+    }
+    return NULL;
+}
+
+// Etapa 4: insere no índice as pistas distintas da partição
+static void *indexarParticao(void *argumento) {
+    TrabalhoCarga *trabalho = (TrabalhoCarga*)argumento;
+    CargaCatalogo *carga = trabalho->carga;
+    IndicePistas *indice = &carga->hash->indice;
+    int primeira = carga->inicioParticao[trabalho->indice];
+    int ultima = carga->inicioParticao[trabalho->indice + 1];
+    // A partição nunca tem mais pistas que associações: usa a mesma faixa do bloco
+    HashNode *nos = carga->nosCarga + primeira;
+    int distintas = 0;
+    
+    for (int k = primeira; k < ultima; k++) {
+        LinhaCatalogo *linha = &carga->linhas[carga->ordem[k]];
+        const HashNode *no = indice_buscarNoBalde(indice, linha->balde, linha->pista);
+        if (no == NULL) {
+            HashNode *novo = &nos[distintas];
+            novo->pista = linha->pista;
+            novo->idPista = distintas++;
+            indice_ligar(indice, linha->balde, novo);
+            no = novo;
+        }
+        linha->idPista = no->idPista;
+    }
+    
+    trabalho->pistasParticao = distintas;
+    return NULL;
+}
+
+// Etapa 5: copia os nós da partição para o bloco definitivo, a partir do
+// id global da primeira pista, corrige os ponteiros dos baldes da
+// partição e liga os bits das pistas no filtro
+static void *publicarPistasParticao(void *argumento) {
+    TrabalhoCarga *trabalho = (TrabalhoCarga*)argumento;
+    CargaCatalogo *carga = trabalho->carga;
+    TabelaHash *hash = carga->hash;
+    IndicePistas *indice = &hash->indice;
+    int base = carga->primeiraPista[trabalho->indice];
+    const HashNode *origem = carga->nosCarga + carga->inicioParticao[trabalho->indice];
+    HashNode *destino = hash->arquivo.nos + base;
+    
+    for (int i = 0; i < trabalho->pistasParticao; i++) {
+        destino[i] = origem[i];
+        destino[i].idPista += base;
+        adicionarAoFiltro(hash->filtro, hash->blocosFiltro, destino[i].pista);
+    }
+    
+    // Os baldes da partição são os de número congruente a ela
+    for (unsigned int b = (unsigned int)trabalho->indice; b < indice->totalBaldes;
+         b += (unsigned int)carga->totalThreads) {
+        const HashNode **elo = &indice->baldes[b];
+        while (*elo != NULL) {
+            HashNode *no = &destino[*elo - origem];
+            *elo = no;
+            elo = &no->proximo;
+        }
+    }
+    return NULL;
+}
+
+// Etapa 6: resume as associações da partição, na ordem da partição, no
+// bloco dos nós provisórios (já copiados por todas as threads)
+static void *resumirAssociacoesParticao(void *argumento) {
+    TrabalhoCarga *trabalho = (TrabalhoCarga*)argumento;
+    CargaCatalogo *carga = trabalho->carga;
+    int primeira = carga->inicioParticao[trabalho->indice];
+    int ultima = carga->inicioParticao[trabalho->indice + 1];
+    
+    for (int k = primeira; k < ultima; k++) {
+        const LinhaCatalogo *linha = &carga->linhas[carga->ordem[k]];
+        carga->associacoes[k] = (AssociacaoCarga){ linha->idPista, linha->idSuspeito, linha->peso };
+    }
+    return NULL;
+}
+
+// Etapa 7: monta as linhas do CSR das pistas da partição (mesma ordenação
+// por contagem de compactarEvidencias, restrita à faixa da partição)
+static void *montarMatrizParticao(void *argumento) {
+    TrabalhoCarga *trabalho = (TrabalhoCarga*)argumento;
+    CargaCatalogo *carga = trabalho->carga;
+    TabelaHash *hash = carga->hash;
+    const AssociacaoCarga *associacoes = carga->associacoes;
+    int primeira = carga->inicioParticao[trabalho->indice];
+    int ultima = carga->inicioParticao[trabalho->indice + 1];
+    int distintas = trabalho->pistasParticao;
+    int *inicio = hash->inicioPista + carga->primeiraPista[trabalho->indice];
+    
+    for (int i = 0; i < distintas; i++) {
+        inicio[i] = 0;
+    }
+    for (int k = primeira; k < ultima; k++) {
+        inicio[associacoes[k].idPista]++;
+    }
+    
+    // Soma prefixada a partir do começo da partição no CSR
+    int acumulado = primeira;
+    for (int i = 0; i < distintas; i++) {
+        int quantidade = inicio[i];
+        inicio[i] = acumulado;
+        acumulado += quantidade;
+    }
+    
+    for (int k = primeira; k < ultima; k++) {
+        int posicao = inicio[associacoes[k].idPista]++;
+        hash->suspeitoEvidencia[posicao] = associacoes[k].idSuspeito;
+        hash->pesoEvidencia[posicao] = associacoes[k].peso;
+    }
+    
+    // Restaura os começos de linha (só dentro da faixa da partição)
+    for (int i = distintas - 1; i > 0; i--) {
+        inicio[i] = inicio[i - 1];
+    }
+    if (distintas > 0) {
+        inicio[0] = primeira;
+    }
+    return NULL;
+}
+
+/*
+ * Função: alocarCarga
+ * Descrição: malloc com a mensagem de erro da carga de catálogos
+ */
+static void *alocarCarga(size_t bytes) {
+    void *memoria = malloc(bytes > 0 ? bytes : 1);
+    if (memoria == NULL) {
+        printf("Erro ao alocar memória para o catálogo!\n");
+        exit(1);
+    }
+    return memoria;
+}
+
+/*
+ * Função: mapearArquivo
+ * Descrição: Mapeia um arquivo de dados em uma cópia privada e gravável,
+ *            com um byte zerado reservado além do fim, que termina a
+ *            última linha mesmo sem \n. Solte com munmap(dados, tamanho + 1).
+ * Parâmetros:
+ *   - caminho: arquivo a mapear (não pode estar vazio)
+ *   - descricao: tipo do arquivo (ex.: "catálogo"), para as mensagens de erro
+ *   - tamanho: recebe o tamanho do arquivo
+ * Retorno: início dos dados mapeados
+ */
+static char *mapearArquivo(const char *caminho, const char *descricao, size_t *tamanho) {
+    int arquivo = open(caminho, O_RDONLY);
+    if (arquivo < 0) {
+        printf("Erro: não foi possível abrir o arquivo de %s \"%s\"!\n", descricao, caminho);
+        exit(1);
+    }
+    struct stat info;
+    if (fstat(arquivo, &info) != 0 || info.st_size == 0) {
+        printf("Erro: arquivo de %s \"%s\" vazio ou ilegível!\n", descricao, caminho);
+        exit(1);
+    }
+    *tamanho = (size_t)info.st_size;
+    
+    // Reserva o byte extra com um mapeamento anônimo e mapeia o arquivo
+    // por cima
+    char *dados = (char*)mmap(NULL, *tamanho + 1, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (dados == MAP_FAILED ||
+        mmap(dados, *tamanho, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, arquivo, 0) == MAP_FAILED) {
+        printf("Erro: não foi possível mapear o arquivo de %s \"%s\"!\n", descricao, caminho);
+        exit(1);
+    }
+    close(arquivo);
+    madvise(dados, *tamanho, MADV_WILLNEED);
+    return dados;
+}
+
+/*
+ * Função: carregarCatalogo
+ * Descrição: Monta uma tabela hash a partir de um arquivo de catálogo
+ *            (TSV ou CSV), já compactada e cheia: inserirNaHash não
+ *            acrescenta nada a ela. Libere com liberarHash.
+ * Parâmetros:
+ *   - hash: tabela a preencher
+ *   - caminho: caminho do arquivo
+ *   - carga: estado da carga, do chamador (só é usado durante a chamada)
+ * Retorno: void
+ */
+void carregarCatalogo(TabelaHash *hash, const char *caminho, CargaCatalogo *carga) {
+    PERFIL_MEDIR(PERFIL_CARREGAR_CATALOGO);
+    
+    size_t tamanho;
+    char *dados = mapearArquivo(caminho, "catálogo", &tamanho);
+    
+    memset(carga, 0, sizeof(*carga));
+    carga->hash = hash;
+    
+    // Separador pela primeira linha
+    char *fimPrimeira = (char*)memchr(dados, '\n', tamanho);
+    size_t tamanhoPrimeira = fimPrimeira != NULL ? (size_t)(fimPrimeira - dados) : tamanho;
+    carga->separador = memchr(dados, '\t', tamanhoPrimeira) != NULL ? '\t' : ',';
+    
+    // Uma thread por processador, cada uma com ao menos BYTES_POR_THREAD
+    long processadores = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threads = tamanho / BYTES_POR_THREAD;
+    if (processadores > 0 && threads > (size_t)processadores) {
+        threads = (size_t)processadores;
+    }
+    if (threads > MAX_THREADS_CARGA) {
+        threads = MAX_THREADS_CARGA;
+    }
+    carga->totalThreads = threads > 0 ? (int)threads : 1;
+    
+    // Trechos começam sempre no início de uma linha
+    char *fimDados = dados + tamanho;
+    for (int t = 0; t < carga->totalThreads; t++) {
+        TrabalhoCarga *trabalho = &carga->trabalhos[t];
+        trabalho->carga = carga;
+        trabalho->indice = t;
+        trabalho->inicio = dados;
+        if (t > 0) {
+            char *nominal = dados + tamanho / (size_t)carga->totalThreads * (size_t)t;
+            char *quebra = (char*)memchr(nominal - 1, '\n', (size_t)(fimDados - nominal + 1));
+            trabalho->inicio = quebra != NULL ? quebra + 1 : fimDados;
+            carga->trabalhos[t - 1].fim = trabalho->inicio;
+        }
+    }
+    carga->trabalhos[carga->totalThreads - 1].fim = fimDados;
+    
+    // Etapa 1: linhas por trecho definem onde cada um grava em linhas[]
+    executarEtapa(carga, contarLinhasTrecho);
+    long long totalLinhas = 0;
+    for (int t = 0; t < carga->totalThreads; t++) {
+        carga->trabalhos[t].primeiraLinha = (int)totalLinhas;
+        totalLinhas += carga->trabalhos[t].totalLinhas;
+        if (totalLinhas >= INT_MAX) {
+            printf("Erro: catálogo \"%s\" com linhas demais!\n", caminho);
+            exit(1);
+        }
+    }
+    carga->linhas = (LinhaCatalogo*)alocarCarga(sizeof(LinhaCatalogo) * (size_t)totalLinhas);
+    
+    // Índice com até duas pistas por balde, mesmo que todas sejam distintas
+    indice_inicializar(&hash->indice, totalLinhas / 2 > TAMANHO_HASH ? (unsigned int)(totalLinhas / 2) : TAMANHO_HASH);
+    
+    // Etapa 2: campos e suspeitos de cada trecho
+    executarEtapa(carga, separarCamposTrecho);
+    int maxSuspeitos = 0;
+    for (int t = 0; t < carga->totalThreads; t++) {
+        if (carga->trabalhos[t].linhaErro > 0) {
+            printf("Erro: linha %d do catálogo \"%s\" malformada!\n", carga->trabalhos[t].linhaErro, caminho);
+            exit(1);
+        }
+        maxSuspeitos += carga->trabalhos[t].totalNomes;
+    }
+    
+    // Ids globais dos suspeitos, na ordem em que aparecem no arquivo
+    IndiceNomes suspeitos;
+    const char **nomesSuspeitos = (const char**)alocarCarga(sizeof(const char*) * (size_t)maxSuspeitos);
+    int totalSuspeitos = 0;
+    nomes_inicializar(&suspeitos, BALDES_SUSPEITOS);
+    for (int t = 0; t < carga->totalThreads; t++) {
+        TrabalhoCarga *trabalho = &carga->trabalhos[t];
+        trabalho->traducao = (int*)alocarCarga(sizeof(int) * (size_t)trabalho->totalNomes);
+        for (int i = 0; i < trabalho->totalNomes; i++) {
+            const NomeNode *nome = nomes_buscar(&suspeitos, trabalho->nomesTrecho[i]);
+            if (nome == NULL) {
+                NomeNode *novo = nomes_inserir(&suspeitos, trabalho->nomesTrecho[i]);
+                novo->id = totalSuspeitos;
+                nomesSuspeitos[totalSuspeitos++] = novo->nome;
+                nome = novo;
+            }
+            trabalho->traducao[i] = nome->id;
+        }
+    }
+    nomes_liberar(&suspeitos);
+    
+    // Faixa de cada partição em ordem[] e onde cada trecho escreve nela
+    int totalAssociacoes = 0;
+    for (int p = 0; p < carga->totalThreads; p++) {
+        carga->inicioParticao[p] = totalAssociacoes;
+        for (int t = 0; t < carga->totalThreads; t++) {
+            int quantidade = carga->trabalhos[t].particao[p];
+            carga->trabalhos[t].particao[p] = totalAssociacoes;
+            totalAssociacoes += quantidade;
+        }
+    }
+    carga->inicioParticao[carga->totalThreads] = totalAssociacoes;
+    if (totalAssociacoes == 0) {
+        printf("Erro: catálogo \"%s\" sem associações!\n", caminho);
+        exit(1);
+    }
+    carga->ordem = (int*)alocarCarga(sizeof(int) * (size_t)totalAssociacoes);
+    
+    // Etapas 3 e 4: agrupa por partição e indexa as pistas em nós provisórios
+    executarEtapa(carga, distribuirLinhasTrecho);
+    for (int t = 0; t < carga->totalThreads; t++) {
+        nomes_liberar(&carga->trabalhos[t].suspeitosTrecho);
+        free(carga->trabalhos[t].nomesTrecho);
+        free(carga->trabalhos[t].traducao);
+    }
+    carga->nosCarga = (HashNode*)alocarCarga(sizeof(HashNode) * (size_t)totalAssociacoes);
+    executarEtapa(carga, indexarParticao);
+    
+    int totalPistas = 0;
+    for (int p = 0; p < carga->totalThreads; p++) {
+        carga->primeiraPista[p] = totalPistas;
+        totalPistas += carga->trabalhos[p].pistasParticao;
+    }
+    
+    // Etapa 5: nós no tamanho exato, uma posição por pista distinta, e filtro
+    hash->arquivo.dados = dados;
+    hash->arquivo.tamanho = tamanho + 1;
+    hash->arquivo.nos = (HashNode*)alocarCarga(sizeof(HashNode) * (size_t)totalPistas);
+    PERFIL_ALOCACAO(PERFIL_CARREGAR_CATALOGO);
+    alocarFiltro(hash, totalPistas);
+    PERFIL_ALOCACAO(PERFIL_CARREGAR_CATALOGO);
+    executarEtapa(carga, publicarPistasParticao);
+    
+    // Etapa 6: só pista, suspeito e peso seguem para o CSR; as linhas são
+    // soltas antes de alocá-lo
+    carga->associacoes = (AssociacaoCarga*)carga->nosCarga;
+    executarEtapa(carga, resumirAssociacoesParticao);
+    free(carga->ordem);
+    free(carga->linhas);
+    carga->ordem = NULL;
+    carga->linhas = NULL;
+    
+    // Suspeitos e CSR em um só bloco, no tamanho exato
+    size_t bytes = sizeof(const char*) * (size_t)totalSuspeitos
+                 + sizeof(int) * ((size_t)totalPistas + 1 + 2 * (size_t)totalAssociacoes);
+    char *bloco = (char*)alocarCarga(bytes);
+    PERFIL_ALOCACAO(PERFIL_CARREGAR_CATALOGO);
+    hash->memoria = bloco;
+    hash->suspeitos = (const char**)bloco;
+    memcpy(hash->suspeitos, nomesSuspeitos, sizeof(const char*) * (size_t)totalSuspeitos);
+    hash->inicioPista = (int*)(hash->suspeitos + totalSuspeitos);
+    hash->suspeitoEvidencia = hash->inicioPista + totalPistas + 1;
+    hash->pesoEvidencia = hash->suspeitoEvidencia + totalAssociacoes;
+    free(nomesSuspeitos);
+    
+    // Etapa 7: matriz de evidências
+    executarEtapa(carga, montarMatrizParticao);
+    hash->inicioPista[totalPistas] = totalAssociacoes;
+    free(carga->nosCarga);
+    carga->nosCarga = NULL;
+    carga->associacoes = NULL;
+    
+    hash->totalPistas = totalPistas;
+    hash->capacidadePistas = totalPistas;
+    hash->totalSuspeitos = totalSuspeitos;
+    hash->capacidadeSuspeitos = totalSuspeitos;
+    hash->evidencias = NULL;
+    hash->totalEvidencias = totalAssociacoes;
+    hash->capacidadeEvidencias = totalAssociacoes;
+    hash->compactada = 1;
+}
+
+/*
+ * Carga de mansões
+ * Um arquivo de mansão descreve o grafo de salas com uma instrução por
+ * linha, campos separados por TAB:
+ *   porta     SALA_A  SALA_B  [CUSTO]   porta nos dois sentidos
+ *   passagem  SALA_A  SALA_B  [CUSTO]   só de A para B (escada, alçapão...)
+ *   pista     SALA    TEXTO
+ *   entrada   SALA                      sala inicial (padrão: a primeira citada)
+ * Linhas vazias e começadas por # são ignoradas. As salas recebem ids na
+ * ordem em que aparecem; nomes que só diferem em maiúsculas são a mesma sala.
+ */
+
+#define CUSTO_MAXIMO_PORTA 1000000   // Maior custo aceito para uma porta
+
+// Porta lida do arquivo, antes de montar o CSR
+typedef struct {
+    int origem;
+    int destino;
+    unsigned int custo;
+} PortaCarga;
+
+// Salas e portas acumuladas durante a carga
+typedef struct {
+    GrafoMansao *mansao;
+    const char **nomes;
+    const char **pistas;
+    int totalSalas;
+    int capacidadeSalas;
+    PortaCarga *portas;
+    int totalPortas;
+    int capacidadePortas;
+} CargaMansao;
+
+// Id da sala com o nome, criando-a na primeira vez (-1 se o nome é vazio)
+static int salaDaCarga(CargaMansao *carga, const char *nome) {
+    if (*nome == '\0') {
+        return -1;
+    }
+    const SalaNode *sala = salas_buscar(&carga->mansao->indice, nome);
+    if (sala != NULL) {
+        return sala->id;
+    }
+    
+    if (carga->totalSalas == carga->capacidadeSalas) {
+        carga->capacidadeSalas = carga->capacidadeSalas > 0 ? 2 * carga->capacidadeSalas : 64;
+        carga->nomes = (const char**)realloc(carga->nomes, sizeof(const char*) * (size_t)carga->capacidadeSalas);
+        carga->pistas = (const char**)realloc(carga->pistas, sizeof(const char*) * (size_t)carga->capacidadeSalas);
+        if (carga->nomes == NULL || carga->pistas == NULL) {
+            printf("Erro ao alocar memória para a mansão!\n");
+            exit(1);
+        }
+    }
+    SalaNode *nova = salas_inserir(&carga->mansao->indice, nome);
+    nova->id = carga->totalSalas;
+    carga->nomes[carga->totalSalas] = nome;
+    carga->pistas[carga->totalSalas] = "";
+    return carga->totalSalas++;
+}
+
+static void acrescentarPortaCarga(CargaMansao *carga, int origem, int destino, unsigned int custo) {
+    if (carga->totalPortas == carga->capacidadePortas) {
+        if (carga->capacidadePortas > INT_MAX / 2) {
+            printf("Erro: mansão com portas demais!\n");
+            exit(1);
+        }
+        carga->capacidadePortas = carga->capacidadePortas > 0 ? 2 * carga->capacidadePortas : 256;
+        carga->portas = (PortaCarga*)realloc(carga->portas, sizeof(PortaCarga) * (size_t)carga->capacidadePortas);
+        if (carga->portas == NULL) {
+            printf("Erro ao alocar memória para a mansão!\n");
+            exit(1);
+        }
+    }
+    carga->portas[carga->totalPortas++] = (PortaCarga){ origem, destino, custo };
+}
+
+/*
+ * Função: numerarPistas
+ * Descrição: Dá um número a cada texto de pista distinto da mansão (salas
+ *            com o mesmo texto dividem o número, na ordem das salas) e
+ *            monta o índice inverso, das pistas para as salas onde estão
+ * Parâmetros:
+ *   - mansao: mansão com nomes, pistas e portas já montados
+ * Retorno: void
+ */
+void numerarPistas(GrafoMansao *mansao) {
+    int totalSalas = mansao->totalSalas;
+    int comPista = 0;
+    
+    for (int s = 0; s < totalSalas; s++) {
+        comPista += mansao->pistas[s][0] != '\0';
+    }
+    int *pistaDaSala = (int*)malloc(sizeof(int) * ((size_t)totalSalas + 2 * (size_t)comPista + 1));
+    if (pistaDaSala == NULL) {
+        printf("Erro ao alocar memória para a mansão!\n");
+        exit(1);
+    }
+    int *inicio = pistaDaSala + totalSalas;
+    int *salas = inicio + comPista + 1;
+    IndiceNomes textos;
+    int total = 0;
+    
+    nomes_inicializar(&textos, (unsigned int)(2 * comPista + 1));
+    for (int s = 0; s < totalSalas; s++) {
+        const char *pista = mansao->pistas[s];
+        pistaDaSala[s] = -1;
+        if (pista[0] == '\0') {
+            continue;
+        }
+        const NomeNode *no = nomes_buscar(&textos, pista);
+        if (no == NULL) {
+            NomeNode *novo = nomes_inserir(&textos, pista);
+            novo->id = total++;
+            no = novo;
+        }
+        pistaDaSala[s] = no->id;
+    }
+    nomes_liberar(&textos);
+    
+    // Ordenação por contagem das salas pelo número da pista
+    memset(inicio, 0, sizeof(int) * ((size_t)total + 1));
+    for (int s = 0; s < totalSalas; s++) {
+        if (pistaDaSala[s] >= 0) {
+            inicio[pistaDaSala[s] + 1]++;
+        }
+    }
+    for (int c = 0; c < total; c++) {
+        inicio[c + 1] += inicio[c];
+    }
+    for (int s = 0; s < totalSalas; s++) {
+        if (pistaDaSala[s] >= 0) {
+            salas[inicio[pistaDaSala[s]]++] = s;
+        }
+    }
+    memmove(inicio + 1, inicio, sizeof(int) * (size_t)total);
+    inicio[0] = 0;
+    
+    mansao->totalPistas = total;
+    mansao->pistaDaSala = pistaDaSala;
+    mansao->inicioSalasPista = inicio;
+    mansao->salasPista = salas;
+    mansao->memoriaPistas = pistaDaSala;
+}
+
+/*
+ * Função: carregarMansao
+ * Descrição: Monta o grafo da mansão a partir de um arquivo (formato
+ *            acima). Nomes e pistas apontam para o arquivo mapeado; as
+ *            portas de cada sala ficam na ordem do arquivo. Libere com
+ *            liberarMansao.
+ * Parâmetros:
+ *   - mansao: grafo a preencher
+ *   - caminho: caminho do arquivo
+ * Retorno: void
+ */
+void carregarMansao(GrafoMansao *mansao, const char *caminho) {
+    size_t tamanho;
+    char *dados = mapearArquivo(caminho, "mansão", &tamanho);
+    char *fimDados = dados + tamanho;
+    
+    // O índice de nomes fica com no máximo uma sala por balde em média
+    // (cada linha cita no máximo duas salas novas)
+    size_t totalLinhas = 1;
+    for (char *c = dados; (c = (char*)memchr(c, '\n', (size_t)(fimDados - c))) != NULL; c++) {
+        totalLinhas++;
+    }
+    if (totalLinhas > INT_MAX / 2) {
+        printf("Erro: mansão \"%s\" com linhas demais!\n", caminho);
+        exit(1);
+    }
+    salas_inicializar(&mansao->indice, (unsigned int)(2 * totalLinhas));
+    
+    CargaMansao carga = { .mansao = mansao };
+    int entrada = 0;
+    int custosUnitarios = 1;
+    size_t numeroLinha = 0;
+    
+    for (char *linha = dados; linha < fimDados; ) {
+        char *fimLinha = (char*)memchr(linha, '\n', (size_t)(fimDados - linha));
+        if (fimLinha == NULL) {
+            fimLinha = fimDados;    // Byte zerado reservado por mapearArquivo
+        }
+        *fimLinha = '\0';
+        if (fimLinha > linha && fimLinha[-1] == '\r') {
+            fimLinha[-1] = '\0';
+        }
+        char *proximaLinha = fimLinha + 1;
+        numeroLinha++;
+        
+        if (*linha == '\0' || *linha == '#') {
+            linha = proximaLinha;
+            continue;
+        }
+        
+        char *campos[4];
+        int totalCampos = 0;
+        for (char *c = linha; c != NULL && totalCampos < 4; ) {
+            campos[totalCampos++] = c;
+            c = strchr(c, '\t');
+            if (c != NULL) {
+                *c++ = '\0';
+            }
+        }
+        
+        int valida = 0;
+        int ehPorta = strcmp(campos[0], "porta") == 0;
+        if ((ehPorta || strcmp(campos[0], "passagem") == 0) && (totalCampos == 3 || totalCampos == 4)) {
+            unsigned long custo = 1;
+            char *resto = NULL;
+            if (totalCampos == 4) {
+                custo = strtoul(campos[3], &resto, 10);
+            }
+            int origem = salaDaCarga(&carga, campos[1]);
+            int destino = salaDaCarga(&carga, campos[2]);
+            valida = origem >= 0 && destino >= 0 && custo >= 1 && custo <= CUSTO_MAXIMO_PORTA &&
+                     (resto == NULL || (resto != campos[3] && *resto == '\0'));
+            if (valida) {
+                acrescentarPortaCarga(&carga, origem, destino, (unsigned int)custo);
+                if (ehPorta) {
+                    acrescentarPortaCarga(&carga, destino, origem, (unsigned int)custo);
+                }
+                custosUnitarios &= custo == 1;
+            }
+        } else if (strcmp(campos[0], "pista") == 0 && totalCampos == 3) {
+            int sala = salaDaCarga(&carga, campos[1]);
+            valida = sala >= 0;
+            if (valida) {
+                carga.pistas[sala] = campos[2];
+            }
+        } else if (strcmp(campos[0], "entrada") == 0 && totalCampos == 2) {
+            entrada = salaDaCarga(&carga, campos[1]);
+            valida = entrada >= 0;
+        }
+        
+        if (!valida) {
+            printf("Erro: linha %zu da mansão \"%s\" inválida!\n", numeroLinha, caminho);
+            exit(1);
+        }
+        linha = proximaLinha;
+    }
+    
+    if (carga.totalSalas == 0) {
+        printf("Erro: mansão \"%s\" sem salas!\n", caminho);
+        exit(1);
+    }
+    int totalSalas = carga.totalSalas;
+    int totalPortas = carga.totalPortas;
+    
+    // Nomes, pistas e CSR em um só bloco: ponteiros, inteiros e rótulos
+    size_t bytes = 2 * sizeof(const char*) * (size_t)totalSalas
+                 + sizeof(int) * ((size_t)totalSalas + 1 + (size_t)totalPortas)
+                 + (custosUnitarios ? 0 : sizeof(unsigned int) * (size_t)totalPortas)
+                 + (size_t)totalPortas;
+    char *bloco = (char*)malloc(bytes);
+    if (bloco == NULL) {
+        printf("Erro ao alocar memória para a mansão!\n");
+        exit(1);
+    }
+    const char **nomes = (const char**)bloco;
+    const char **pistas = nomes + totalSalas;
+    int *inicioPortas = (int*)(pistas + totalSalas);
+    int *destinoPorta = inicioPortas + totalSalas + 1;
+    unsigned int *custoPorta = custosUnitarios ? NULL : (unsigned int*)(destinoPorta + totalPortas);
+    char *rotuloPorta = custoPorta != NULL ? (char*)(custoPorta + totalPortas) : (char*)(destinoPorta + totalPortas);
+    
+    memcpy(nomes, carga.nomes, sizeof(const char*) * (size_t)totalSalas);
+    memcpy(pistas, carga.pistas, sizeof(const char*) * (size_t)totalSalas);
+    memset(rotuloPorta, PORTA_NUMERADA, (size_t)totalPortas);
+    
+    // Ordenação por contagem das portas pela sala de origem (estável)
+    memset(inicioPortas, 0, sizeof(int) * ((size_t)totalSalas + 1));
+    for (int i = 0; i < totalPortas; i++) {
+        inicioPortas[carga.portas[i].origem + 1]++;
+    }
+    for (int s = 0; s < totalSalas; s++) {
+        inicioPortas[s + 1] += inicioPortas[s];
+    }
+    for (int i = 0; i < totalPortas; i++) {
+        int posicao = inicioPortas[carga.portas[i].origem]++;
+        destinoPorta[posicao] = carga.portas[i].destino;
+        if (custoPorta != NULL) {
+            custoPorta[posicao] = carga.portas[i].custo;
+        }
+    }
+    memmove(inicioPortas + 1, inicioPortas, sizeof(int) * (size_t)totalSalas);
+    inicioPortas[0] = 0;
+    
+    mansao->totalSalas = totalSalas;
+    mansao->totalPortas = totalPortas;
+    mansao->entrada = entrada;
+    mansao->nomes = nomes;
+    mansao->pistas = pistas;
+    mansao->inicioPortas = inicioPortas;
+    mansao->destinoPorta = destinoPorta;
+    mansao->custoPorta = custoPorta;
+    mansao->rotuloPorta = rotuloPorta;
+    mansao->memoria = bloco;
+    mansao->dados = dados;
+    mansao->tamanho = tamanho + 1;
+    
+    free(carga.nomes);
+    free(carga.pistas);
+    free(carga.portas);
+    numerarPistas(mansao);
+}
+
+/*
+ * Função: liberarMansao
+ * Descrição: Solta o quadro de evidências e a árvore de rotas montados e,
+ *            numa mansão carregada, o índice de nomes, a numeração das
+ *            pistas, os vetores e o arquivo mapeado. Na padrão, o índice
+ *            e a numeração são tabelas estáticas.
+ */
+void liberarMansao(GrafoMansao *mansao) {
+    if (mansao->memoria != NULL) {
+        salas_liberar(&mansao->indice);
+    }
+    free(mansao->memoriaPistas);
+    free(mansao->quadro.memoria);
+    free(mansao->rotas.memoria);
+    free(mansao->memoria);
+    if (mansao->dados != NULL) {
+        munmap(mansao->dados, mansao->tamanho);
+    }
+}
+
+/*
+ * Cenário padrão
+ * A mansão e o catálogo de pistas do jogo ficam em tabelas estáticas,
+ * montadas pelo compilador: iniciar o jogo não faz nenhuma alocação nem
+ * cópia de strings.
+ */
+
+// Índices das salas na tabela da mansão
+enum {
+    HALL, SALA_ESTAR, COZINHA,
+    BIBLIOTECA, ESCRITORIO, DESPENSA, JARDIM,
+    SALA_SECRETA, SALA_LEITURA, COFRE, ESTUFA,
+    TOTAL_SALAS
+};
+
+static const char *const nomesSalasPadrao[TOTAL_SALAS] = {
+    [HALL]         = "Hall de Entrada",
+    [SALA_ESTAR]   = "Sala de Estar",
+    [COZINHA]      = "Cozinha",
+    [BIBLIOTECA]   = "Biblioteca",
+    [ESCRITORIO]   = "Escritorio",
+    [DESPENSA]     = "Despensa",
+    [JARDIM]       = "Jardim",
+    [SALA_SECRETA] = "Sala Secreta",
+    [SALA_LEITURA] = "Sala de Leitura",
+    [COFRE]        = "Cofre",
+    [ESTUFA]       = "Estufa",
+};
+
+// Pista escondida em cada sala
+static const char *const pistasSalasPadrao[TOTAL_SALAS] = {
+    [HALL]         = "Pegadas molhadas no tapete",
+    [SALA_ESTAR]   = "",
+    [COZINHA]      = "Faca desaparecida do bloco",
+    [BIBLIOTECA]   = "Livro aberto sobre venenos",
+    [ESCRITORIO]   = "",
+    [DESPENSA]     = "Frasco vazio de arsenico",
+    [JARDIM]       = "",
+    [SALA_SECRETA] = "Documento queimado parcialmente",
+    [SALA_LEITURA] = "Carta ameacadora escondida",
+    [COFRE]        = "Testamento adulterado",
+    [ESTUFA]       = "Planta venenosa cultivada",
+};
+
+// Portas da mansão padrão: a árvore clássica com raiz no Hall de Entrada.
+// Cada sala tem as saídas E/D para os cômodos seguintes e a porta V de
+// volta ao anterior.
+static const int inicioPortasPadrao[TOTAL_SALAS + 1] = {
+    [HALL] = 0, [SALA_ESTAR] = 2, [COZINHA] = 5, [BIBLIOTECA] = 8,
+    [ESCRITORIO] = 11, [DESPENSA] = 13, [JARDIM] = 14, [SALA_SECRETA] = 16,
+    [SALA_LEITURA] = 17, [COFRE] = 18, [ESTUFA] = 19, [TOTAL_SALAS] = 20,
+};
+
+static const int destinoPortaPadrao[] = {
+    /* HALL */         SALA_ESTAR, COZINHA,
+    /* SALA_ESTAR */   BIBLIOTECA, ESCRITORIO, HALL,
+    /* COZINHA */      DESPENSA, JARDIM, HALL,
+    /* BIBLIOTECA */   SALA_SECRETA, SALA_LEITURA, SALA_ESTAR,
+    /* ESCRITORIO */   COFRE, SALA_ESTAR,
+    /* DESPENSA */     COZINHA,
+    /* JARDIM */       ESTUFA, COZINHA,
+    /* SALA_SECRETA */ BIBLIOTECA,
+    /* SALA_LEITURA */ BIBLIOTECA,
+    /* COFRE */        ESCRITORIO,
+    /* ESTUFA */       JARDIM,
+};
+
+static const char rotuloPortaPadrao[] = {
+    /* HALL */         'E', 'D',
+    /* SALA_ESTAR */   'E', 'D', 'V',
+    /* COZINHA */      'E', 'D', 'V',
+    /* BIBLIOTECA */   'E', 'D', 'V',
+    /* ESCRITORIO */   'E', 'V',
+    /* DESPENSA */     'V',
+    /* JARDIM */       'D', 'V',
+    /* SALA_SECRETA */ 'V',
+    /* SALA_LEITURA */ 'V',
+    /* COFRE */        'V',
+    /* ESTUFA */       'V',
+};
+
+#define TOTAL_PORTAS_PADRAO ((int)(sizeof(destinoPortaPadrao) / sizeof(destinoPortaPadrao[0])))
+
+// Índice de nomes da mansão padrão, já encadeado por balde. Os baldes foram
+// calculados com hashTextoSemCaixa e BALDES_SALAS_PADRAO; recalcule se algum
+// dos dois ou algum nome mudar.
+#define BALDES_SALAS_PADRAO (2 * TOTAL_SALAS)
+
+static const SalaNode salasPadrao[TOTAL_SALAS] = {
+    [HALL]         = { .nome = "Hall de Entrada", .id = HALL,         .proximo = NULL },
+    [SALA_ESTAR]   = { .nome = "Sala de Estar",   .id = SALA_ESTAR,   .proximo = NULL },
+    [COZINHA]      = { .nome = "Cozinha",         .id = COZINHA,      .proximo = NULL },
+    [BIBLIOTECA]   = { .nome = "Biblioteca",      .id = BIBLIOTECA,
+                       .proximo = &salasPadrao[SALA_SECRETA] },
+    [ESCRITORIO]   = { .nome = "Escritorio",      .id = ESCRITORIO,   .proximo = NULL },
+    [DESPENSA]     = { .nome = "Despensa",        .id = DESPENSA,     .proximo = NULL },
+    [JARDIM]       = { .nome = "Jardim",          .id = JARDIM,       .proximo = NULL },
+    [SALA_SECRETA] = { .nome = "Sala Secreta",    .id = SALA_SECRETA,
+                       .proximo = &salasPadrao[SALA_LEITURA] },
+    [SALA_LEITURA] = { .nome = "Sala de Leitura", .id = SALA_LEITURA, .proximo = NULL },
+    [COFRE]        = { .nome = "Cofre",           .id = COFRE,        .proximo = NULL },
+    [ESTUFA]       = { .nome = "Estufa",          .id = ESTUFA,       .proximo = NULL },
+};
+
+static const SalaNode *const baldesSalasPadrao[BALDES_SALAS_PADRAO] = {
+    [1]  = &salasPadrao[DESPENSA],
+    [5]  = &salasPadrao[HALL],
+    [7]  = &salasPadrao[ESCRITORIO],
+    [9]  = &salasPadrao[COFRE],
+    [10] = &salasPadrao[ESTUFA],
+    [11] = &salasPadrao[JARDIM],
+    [13] = &salasPadrao[SALA_ESTAR],
+    [16] = &salasPadrao[COZINHA],
+    [20] = &salasPadrao[BIBLIOTECA],
+};
+
+// Ids das pistas e dos suspeitos do catálogo padrão
+enum {
+    PISTA_PEGADAS, PISTA_FACA, PISTA_LIVRO, PISTA_FRASCO,
+    PISTA_DOCUMENTO, PISTA_CARTA, PISTA_TESTAMENTO, PISTA_PLANTA,
+    TOTAL_PISTAS_PADRAO
+};
+enum { JARDINEIRO, COZINHEIRO, MORDOMO, ADVOGADO, TOTAL_SUSPEITOS_PADRAO };
+
+// Nós da tabela hash, já encadeados por balde. Os baldes foram calculados
+// com funcaoHash e TAMANHO_HASH 20; recalcule se algum dos dois mudar.
+static const HashNode catalogoPadrao[TOTAL_PISTAS_PADRAO] = {
+    [PISTA_PEGADAS]    = { .pista = "Pegadas molhadas no tapete",      .idPista = PISTA_PEGADAS,
+                           .proximo = &catalogoPadrao[PISTA_DOCUMENTO] },
+    [PISTA_FACA]       = { .pista = "Faca desaparecida do bloco",      .idPista = PISTA_FACA,
+                           .proximo = NULL },
+    [PISTA_LIVRO]      = { .pista = "Livro aberto sobre venenos",      .idPista = PISTA_LIVRO,
+                           .proximo = &catalogoPadrao[PISTA_FRASCO] },
+    [PISTA_FRASCO]     = { .pista = "Frasco vazio de arsenico",        .idPista = PISTA_FRASCO,
+                           .proximo = NULL },
+    [PISTA_DOCUMENTO]  = { .pista = "Documento queimado parcialmente", .idPista = PISTA_DOCUMENTO,
+                           .proximo = NULL },
+    [PISTA_CARTA]      = { .pista = "Carta ameacadora escondida",      .idPista = PISTA_CARTA,
+                           .proximo = NULL },
+    [PISTA_TESTAMENTO] = { .pista = "Testamento adulterado",           .idPista = PISTA_TESTAMENTO,
+                           .proximo = NULL },
+    [PISTA_PLANTA]     = { .pista = "Planta venenosa cultivada",       .idPista = PISTA_PLANTA,
+                           .proximo = NULL },
+};
+
+// Baldes, suspeitos e matriz de evidências do catálogo padrão
+static const HashNode *const baldesPadrao[TAMANHO_HASH] = {
+    [5]  = &catalogoPadrao[PISTA_CARTA],
+    [8]  = &catalogoPadrao[PISTA_LIVRO],
+    [10] = &catalogoPadrao[PISTA_PEGADAS],
+    [15] = &catalogoPadrao[PISTA_FACA],
+    [18] = &catalogoPadrao[PISTA_PLANTA],
+    [19] = &catalogoPadrao[PISTA_TESTAMENTO],
+};
+
+static const char *const suspeitosPadrao[TOTAL_SUSPEITOS_PADRAO] = {
+    [JARDINEIRO] = "Jardineiro",
+    [COZINHEIRO] = "Cozinheiro",
+    [MORDOMO]    = "Mordomo",
+    [ADVOGADO]   = "Advogado",
+};
+
+static const Evidencia evidenciasPadrao[] = {
+    { PISTA_PEGADAS,    JARDINEIRO, 1 },
+    { PISTA_FACA,       COZINHEIRO, 1 },
+    { PISTA_LIVRO,      MORDOMO,    1 },
+    { PISTA_FRASCO,     MORDOMO,    1 },
+    { PISTA_DOCUMENTO,  ADVOGADO,   1 },
+    { PISTA_CARTA,      ADVOGADO,   1 },
+    { PISTA_TESTAMENTO, ADVOGADO,   1 },
+    { PISTA_PLANTA,     JARDINEIRO, 1 },
+};
+
+#define TOTAL_EVIDENCIAS_PADRAO ((int)(sizeof(evidenciasPadrao) / sizeof(evidenciasPadrao[0])))
+
+static const int inicioPistaPadrao[TOTAL_PISTAS_PADRAO + 1] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+static const int suspeitoEvidenciaPadrao[TOTAL_EVIDENCIAS_PADRAO] = {
+    JARDINEIRO, COZINHEIRO, MORDOMO, MORDOMO,
+    ADVOGADO, ADVOGADO, ADVOGADO, JARDINEIRO,
+};
+static const int pesoEvidenciaPadrao[TOTAL_EVIDENCIAS_PADRAO] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+// Filtro de Bloom do catálogo padrão, preenchido por reconstruirFiltro
+static uint64_t filtroPadrao[PALAVRAS_BLOCO_FILTRO] __attribute__((aligned(64)));
+static EstatisticasFiltro estatisticasPadrao;
+
+// Tabela hash pronta, com a matriz de evidências já compactada. Está cheia:
+// inserirNaHash só é usado em tabelas criadas por inicializarHash. Os
+// vetores são somente leitura; as conversões abaixo só ajustam o tipo dos
+// campos, que as funções de montagem escrevem em tabelas alocadas, e a
+// tabela const nunca é passada a elas
+static const TabelaHash hashPadrao = {
+    .indice = { .baldes = (const HashNode**)baldesPadrao, .totalBaldes = TAMANHO_HASH },
+    .totalPistas = TOTAL_PISTAS_PADRAO,
+    .capacidadePistas = TOTAL_PISTAS_PADRAO,
+    .suspeitos = (const char**)suspeitosPadrao,
+    .totalSuspeitos = TOTAL_SUSPEITOS_PADRAO,
+    .capacidadeSuspeitos = TOTAL_SUSPEITOS_PADRAO,
+    .evidencias = (Evidencia*)evidenciasPadrao,
+    .totalEvidencias = TOTAL_EVIDENCIAS_PADRAO,
+    .capacidadeEvidencias = TOTAL_EVIDENCIAS_PADRAO,
+    .inicioPista = (int*)inicioPistaPadrao,
+    .suspeitoEvidencia = (int*)suspeitoEvidenciaPadrao,
+    .pesoEvidencia = (int*)pesoEvidenciaPadrao,
+    .compactada = 1,
+    .filtro = filtroPadrao,
+    .blocosFiltro = 1,
+    .estatisticasFiltro = &estatisticasPadrao,
+};
+
+// Numeração das pistas da mansão padrão (numerarPistas). Cada texto está em
+// uma sala só e as salas seguem a ordem do catálogo, então o número de cada
+// pista coincide com o id dela no catálogo.
+static const int pistaDaSalaPadrao[TOTAL_SALAS] = {
+    [HALL]         = PISTA_PEGADAS,   [SALA_ESTAR]   = -1,
+    [COZINHA]      = PISTA_FACA,      [BIBLIOTECA]   = PISTA_LIVRO,
+    [ESCRITORIO]   = -1,              [DESPENSA]     = PISTA_FRASCO,
+    [JARDIM]       = -1,              [SALA_SECRETA] = PISTA_DOCUMENTO,
+    [SALA_LEITURA] = PISTA_CARTA,     [COFRE]        = PISTA_TESTAMENTO,
+    [ESTUFA]       = PISTA_PLANTA,
+};
+static const int inicioSalasPistaPadrao[TOTAL_PISTAS_PADRAO + 1] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+static const int salasPistaPadrao[TOTAL_PISTAS_PADRAO] = {
+    HALL, COZINHA, BIBLIOTECA, DESPENSA, SALA_SECRETA, SALA_LEITURA, COFRE, ESTUFA,
+};
+
+// Quadro de evidências da mansão padrão contra o catálogo padrão
+// (montarQuadroEvidencias): com pesos 1 basta um plano, e o bit c da
+// palavra de um suspeito é a pista c
+#define PISTA_BIT(pista) (UINT64_C(1) << (pista))
+
+static const uint64_t bitsQuadroPadrao[LOTE_SUSPEITOS] __attribute__((aligned(32))) = {
+    [JARDINEIRO] = PISTA_BIT(PISTA_PEGADAS) | PISTA_BIT(PISTA_PLANTA),
+    [COZINHEIRO] = PISTA_BIT(PISTA_FACA),
+    [MORDOMO]    = PISTA_BIT(PISTA_LIVRO) | PISTA_BIT(PISTA_FRASCO),
+    [ADVOGADO]   = PISTA_BIT(PISTA_DOCUMENTO) | PISTA_BIT(PISTA_CARTA) | PISTA_BIT(PISTA_TESTAMENTO),
+};
+
+// Árvore de rotas da mansão padrão (montarArvoreRotas): a própria árvore
+// das portas E/D, com as salas em ordem de largura a partir do Hall
+static const int ordemRotasPadrao[TOTAL_SALAS] = {
+    HALL, SALA_ESTAR, COZINHA, BIBLIOTECA, ESCRITORIO, DESPENSA,
+    JARDIM, SALA_SECRETA, SALA_LEITURA, COFRE, ESTUFA,
+};
+static const int paiRotasPadrao[TOTAL_SALAS] = {
+    [HALL]         = -1,         [SALA_ESTAR]   = HALL,
+    [COZINHA]      = HALL,       [BIBLIOTECA]   = SALA_ESTAR,
+    [ESCRITORIO]   = SALA_ESTAR, [DESPENSA]     = COZINHA,
+    [JARDIM]       = COZINHA,    [SALA_SECRETA] = BIBLIOTECA,
+    [SALA_LEITURA] = BIBLIOTECA, [COFRE]        = ESCRITORIO,
+    [ESTUFA]       = JARDIM,
+};
+static const int inicioFilhosRotasPadrao[TOTAL_SALAS + 1] = {
+    [HALL] = 0, [SALA_ESTAR] = 2, [COZINHA] = 4, [BIBLIOTECA] = 6,
+    [ESCRITORIO] = 8, [DESPENSA] = 9, [JARDIM] = 9, [SALA_SECRETA] = 10,
+    [SALA_LEITURA] = 10, [COFRE] = 10, [ESTUFA] = 10, [TOTAL_SALAS] = 10,
+};
+static const int filhosRotasPadrao[TOTAL_SALAS - 1] = {
+    SALA_ESTAR, COZINHA, BIBLIOTECA, ESCRITORIO, DESPENSA,
+    JARDIM, SALA_SECRETA, SALA_LEITURA, COFRE, ESTUFA,
+};
+static const int pistaCatalogoPadrao[TOTAL_SALAS] = {
+    [HALL]         = PISTA_PEGADAS,   [SALA_ESTAR]   = -1,
+    [COZINHA]      = PISTA_FACA,      [BIBLIOTECA]   = PISTA_LIVRO,
+    [ESCRITORIO]   = -1,              [DESPENSA]     = PISTA_FRASCO,
+    [JARDIM]       = -1,              [SALA_SECRETA] = PISTA_DOCUMENTO,
+    [SALA_LEITURA] = PISTA_CARTA,     [COFRE]        = PISTA_TESTAMENTO,
+    [ESTUFA]       = PISTA_PLANTA,
+};
+
+// Mansão padrão pronta para o catálogo padrão, somente leitura. Com outro
+// catálogo, main monta o quadro e as rotas numa cópia; o índice e a
+// numeração servem a qualquer catálogo
+static const GrafoMansao mansaoPadrao = {
+    .totalSalas = TOTAL_SALAS,
+    .totalPortas = TOTAL_PORTAS_PADRAO,
+    .entrada = HALL,
+    .nomes = nomesSalasPadrao,
+    .pistas = pistasSalasPadrao,
+    .inicioPortas = inicioPortasPadrao,
+    .destinoPorta = destinoPortaPadrao,
+    .custoPorta = NULL,
+    .rotuloPorta = rotuloPortaPadrao,
+    .totalPistas = TOTAL_PISTAS_PADRAO,
+    .pistaDaSala = pistaDaSalaPadrao,
+    .inicioSalasPista = inicioSalasPistaPadrao,
+    .salasPista = salasPistaPadrao,
+    .indice = { .baldes = (const SalaNode**)baldesSalasPadrao, .totalBaldes = BALDES_SALAS_PADRAO },
+    .quadro = {
+        .ativo = 1,
+        .totalPistas = TOTAL_PISTAS_PADRAO,
+        .palavras = 1,
+        .planos = 1,
+        .totalSuspeitos = TOTAL_SUSPEITOS_PADRAO,
+        .colunas = LOTE_SUSPEITOS,
+        .bits = bitsQuadroPadrao,
+    },
+    .rotas = {
+        .ordem = ordemRotasPadrao,
+        .totalOrdem = TOTAL_SALAS,
+        .pai = paiRotasPadrao,
+        .inicioFilhos = inicioFilhosRotasPadrao,
+        .filhos = filhosRotasPadrao,
+        .pistaCatalogo = pistaCatalogoPadrao,
+    },
+};
+
+// Buffer de saída estático, para que o stdio não aloque o seu
+static char bufferSaida[BUFSIZ];
+
+/*
+ * Função: escrever
+ * Descrição: printf para a saída de uma partida. Sem arquivo, o texto é
+ *            acumulado no buffer, que cresce conforme a necessidade;
+ *            numa saída descartada nem chega a ser formatado.
+ * Parâmetros:
+ *   - saida: destino do texto
+ *   - formato: formato do printf, seguido dos argumentos
+ * Retorno: void
+ */
+__attribute__((format(printf, 2, 3)))
+void escrever(Saida *saida, const char *formato, ...) {
+    va_list argumentos;
+    
+    if (saida->descartar) {
+        return;
+    }
+    va_start(argumentos, formato);
+    if (saida->arquivo != NULL) {
+        vfprintf(saida->arquivo, formato, argumentos);
+        va_end(argumentos);
+        return;
+    }
+    
+    va_list copia;
+    va_copy(copia, argumentos);
+    char *livre = saida->dados != NULL ? saida->dados + saida->tamanho : NULL;
+    int tamanho = vsnprintf(livre, saida->capacidade - saida->tamanho, formato, argumentos);
+    va_end(argumentos);
+    
+    if (tamanho >= 0 && saida->tamanho + (size_t)tamanho >= saida->capacidade) {
+        size_t capacidade = saida->capacidade > 0 ? saida->capacidade : 1024;
+        while (capacidade <= saida->tamanho + (size_t)tamanho) {
+            capacidade *= 2;
+        }
+        char *dados = (char*)realloc(saida->dados, capacidade);
+        if (dados == NULL) {
+            printf("Erro ao alocar memória para a saída!\n");
+            exit(1);
+        }
+        saida->dados = dados;
+        saida->capacidade = capacidade;
+        vsnprintf(saida->dados + saida->tamanho, capacidade - saida->tamanho, formato, copia);
+    }
+    va_end(copia);
+    
+    if (tamanho > 0) {
+        saida->tamanho += (size_t)tamanho;
+    }
+}
+
+/*
+ * Rotas pela mansão
+ * Um percurso visita as salas alcançáveis a partir de uma origem em
+ * ordem de distância: busca em largura quando todas as portas custam 1,
+ * Dijkstra com heap binário quando há custos. Os vetores têm uma posição
+ * por sala e só são alocados pelo primeiro comando que pede rotas (goto
+ * ou P); cada sessão os reaproveita, e um novo percurso só troca a época
+ * em vez de limpá-los. Andar de uma sala para outra custa O(portas da sala).
+ */
+
+static void inserirNoHeap(Percurso *percurso, long long distancia, int sala) {
+    if (percurso->totalHeap == percurso->capacidadeHeap) {
+        percurso->capacidadeHeap *= 2;
+        percurso->heap = (EntradaHeap*)realloc(percurso->heap, sizeof(EntradaHeap) * (size_t)percurso->capacidadeHeap);
+        if (percurso->heap == NULL) {
+            printf("Erro ao alocar memória para a rota!\n");
+            exit(1);
+        }
+    }
+    int i = percurso->totalHeap++;
+    while (i > 0 && percurso->heap[(i - 1) / 2].distancia > distancia) {
+        percurso->heap[i] = percurso->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    percurso->heap[i] = (EntradaHeap){ distancia, sala };
+}
+
+static EntradaHeap retirarDoHeap(Percurso *percurso) {
+    EntradaHeap raiz = percurso->heap[0];
+    EntradaHeap ultima = percurso->heap[--percurso->totalHeap];
+    int i = 0;
+    for (;;) {
+        int filho = 2 * i + 1;
+        if (filho >= percurso->totalHeap) {
+            break;
+        }
+        if (filho + 1 < percurso->totalHeap &&
+            percurso->heap[filho + 1].distancia < percurso->heap[filho].distancia) {
+            filho++;
+        }
+        if (ultima.distancia <= percurso->heap[filho].distancia) {
+            break;
+        }
+        percurso->heap[i] = percurso->heap[filho];
+        i = filho;
+    }
+    if (percurso->totalHeap > 0) {
+        percurso->heap[i] = ultima;
+    }
+    return raiz;
+}
+
+/*
+ * Função: iniciarPercurso
+ * Descrição: Prepara um percurso a partir da sala de origem. Na primeira
+ *            vez aloca os vetores por sala; nas seguintes só avança a
+ *            época, e as salas do percurso anterior deixam de valer.
+ * Parâmetros:
+ *   - percurso: percurso a preparar, vazio ({ .memoria = NULL }) ou já
+ *     usado na mesma mansão (libere com liberarPercurso)
+ *   - mansao: grafo percorrido
+ *   - origem: sala de partida
+ * Retorno: void
+ */
+void iniciarPercurso(Percurso *percurso, const GrafoMansao *mansao, int origem) {
+    size_t salas = (size_t)mansao->totalSalas;
+    
+    if (percurso->memoria == NULL) {
+        percurso->memoria = calloc(salas > 0 ? salas : 1,
+                                   sizeof(long long) + 3 * sizeof(int) + sizeof(unsigned int));
+        if (percurso->memoria == NULL) {
+            printf("Erro ao alocar memória para a rota!\n");
+            exit(1);
+        }
+        percurso->mansao = mansao;
+        percurso->distancia = (long long*)percurso->memoria;
+        percurso->anterior = (int*)(percurso->distancia + salas);
+        percurso->porta = percurso->anterior + salas;
+        percurso->fila = percurso->porta + salas;
+        percurso->visita = (unsigned int*)(percurso->fila + salas);
+        percurso->epoca = 0;
+        percurso->heap = NULL;
+        percurso->capacidadeHeap = 0;
+    }
+    
+    // Época 0 marca as salas nunca alcançadas: ao dar a volta, limpa as marcas
+    if (++percurso->epoca == 0) {
+        memset(percurso->visita, 0, sizeof(unsigned int) * salas);
+        percurso->epoca = 1;
+    }
+    percurso->visita[origem] = percurso->epoca;
+    percurso->distancia[origem] = 0;
+    percurso->anterior[origem] = -1;
+    percurso->porta[origem] = -1;
+    
+    if (mansao->custoPorta == NULL) {
+        percurso->fila[0] = origem;
+        percurso->inicioFila = 0;
+        percurso->fimFila = 1;
+    } else {
+        if (percurso->heap == NULL) {
+            percurso->capacidadeHeap = 64;
+            percurso->heap = (EntradaHeap*)malloc(sizeof(EntradaHeap) * (size_t)percurso->capacidadeHeap);
+            if (percurso->heap == NULL) {
+                printf("Erro ao alocar memória para a rota!\n");
+                exit(1);
+            }
+        }
+        percurso->totalHeap = 0;
+        inserirNoHeap(percurso, 0, origem);
+    }
+}
+
+/*
+ * Função: proximaSalaPercurso
+ * Descrição: Fixa a próxima sala mais próxima da origem (a primeira é a
+ *            própria origem) e registra as rotas pelas portas dela
+ * Retorno: id da sala, ou -1 quando não há mais salas alcançáveis
+ */
+int proximaSalaPercurso(Percurso *percurso) {
+    const GrafoMansao *mansao = percurso->mansao;
+    int sala;
+    
+    if (mansao->custoPorta == NULL) {
+        if (percurso->inicioFila == percurso->fimFila) {
+            return -1;
+        }
+        sala = percurso->fila[percurso->inicioFila++];
+    } else {
+        // Entradas superadas por uma rota mais curta são descartadas
+        for (;;) {
+            if (percurso->totalHeap == 0) {
+                return -1;
+            }
+            EntradaHeap entrada = retirarDoHeap(percurso);
+            sala = entrada.sala;
+            if (entrada.distancia == percurso->distancia[sala]) {
+                break;
+            }
+        }
+    }
+    
+    long long distancia = percurso->distancia[sala];
+    for (int p = mansao->inicioPortas[sala]; p < mansao->inicioPortas[sala + 1]; p++) {
+        int destino = mansao->destinoPorta[p];
+        long long nova = distancia + (mansao->custoPorta != NULL ? mansao->custoPorta[p] : 1);
+        if (percurso->visita[destino] == percurso->epoca && percurso->distancia[destino] <= nova) {
+            continue;
+        }
+        percurso->visita[destino] = percurso->epoca;
+        percurso->distancia[destino] = nova;
+        percurso->anterior[destino] = sala;
+        percurso->porta[destino] = p;
+        if (mansao->custoPorta == NULL) {
+            percurso->fila[percurso->fimFila++] = destino;
+        } else {
+            inserirNoHeap(percurso, nova, destino);
+        }
+    }
+    return sala;
+}
+
+void liberarPercurso(Percurso *percurso) {
+    free(percurso->memoria);
+    free(percurso->heap);
+    percurso->memoria = NULL;
+    percurso->heap = NULL;
+}
+
+/*
+ * Função: reservarMovimentos
+ * Descrição: Garante espaço na fila para mais movimentos, trocando o vetor
+ *            local (ou o alocado) por um maior, com a fila desenrolada
+ * Parâmetros:
+ *   - fila: ponteiro para a fila de movimentos
+ *   - quantidade: movimentos que serão acrescentados
+ * Retorno: void
+ */
+void reservarMovimentos(FilaMovimentos *fila, int quantidade) {
+    if (quantidade <= fila->capacidade - fila->total) {
+        return;
+    }
+    if (quantidade > INT_MAX / 2 - fila->total) {
+        printf("Erro: movimentos demais na fila!\n");
+        exit(1);
+    }
+    int capacidade = fila->capacidade;
+    while (capacidade - fila->total < quantidade) {
+        capacidade *= 2;
+    }
+    int *movimentos = (int*)malloc(sizeof(int) * (size_t)capacidade);
+    if (movimentos == NULL) {
+        printf("Erro ao alocar memória para a fila de movimentos!\n");
+        exit(1);
+    }
+    for (int i = 0; i < fila->total; i++) {
+        movimentos[i] = fila->movimentos[(fila->inicio + i) % fila->capacidade];
+    }
+    if (fila->movimentos != fila->movimentosLocal) {
+        free(fila->movimentos);
+    }
+    fila->movimentos = movimentos;
+    fila->inicio = 0;
+    fila->capacidade = capacidade;
+}
+
+/*
+ * Função: buscarRota
+ * Descrição: Calcula a rota mais curta (menor custo) entre duas salas e a
+ *            acrescenta à fila: E/D/V nas portas rotuladas e
+ *            MOVIMENTO_PORTA nas numeradas
+ * Parâmetros:
+ *   - percurso: percurso reaproveitado da sessão
+ *   - mansao: grafo da mansão
+ *   - origem, destino: ids das salas
+ *   - fila: recebe os movimentos (cresce se a rota não couber)
+ * Retorno: total de movimentos, ou -1 se o destino é inalcançável
+ */
+int buscarRota(Percurso *percurso, const GrafoMansao *mansao, int origem, int destino, FilaMovimentos *fila) {
+    int sala;
+    
+    iniciarPercurso(percurso, mansao, origem);
+    do {
+        sala = proximaSalaPercurso(percurso);
+    } while (sala >= 0 && sala != destino);
+    
+    if (sala != destino) {
+        return -1;
+    }
+    int total = 0;
+    for (int s = destino; s != origem; s = percurso->anterior[s]) {
+        total++;
+    }
+    
+    // A rota é refeita do destino para a origem: preenche de trás para frente
+    reservarMovimentos(fila, total);
+    int i = fila->total + total;
+    for (int s = destino; s != origem; s = percurso->anterior[s]) {
+        int porta = percurso->porta[s];
+        int anterior = percurso->anterior[s];
+        char rotulo = mansao->rotuloPorta[porta];
+        fila->movimentos[(fila->inicio + --i) % fila->capacidade] =
+            rotulo != PORTA_NUMERADA ? rotulo : MOVIMENTO_PORTA(porta - mansao->inicioPortas[anterior]);
+    }
+    fila->total += total;
+    return total;
+}
+
+/*
+ * Função: exibirPistasAlcancaveis
+ * Descrição: Lista, da mais próxima para a mais distante, as pistas ainda
+ *            fora do diário que podem ser alcançadas da sala atual, a
+ *            começar pela própria (até MAX_PISTAS_ALCANCE)
+ * Parâmetros:
+ *   - sessao: partida em exploração
+ * Retorno: void
+ */
+void exibirPistasAlcancaveis(Sessao *sessao) {
+    const GrafoMansao *mansao = sessao->mansao;
+    Percurso *percurso = &sessao->percurso;
+    int encontradas = 0;
+    int sala;
+    
+    iniciarPercurso(percurso, mansao, sessao->salaAtual);
+    while (encontradas < MAX_PISTAS_ALCANCE && (sala = proximaSalaPercurso(percurso)) >= 0) {
+        if (mansao->pistas[sala][0] == '\0' || sessao->estadoSalas[sala] == SALA_PISTA_COLETADA) {
+            continue;
+        }
+        if (encontradas == 0) {
+            escrever(sessao->saida, "\n🧭 Pistas ao alcance:\n");
+        }
+        if (sala == sessao->salaAtual) {
+            // Pista desfeita nesta sala: volta ao diário ao entrar de novo
+            escrever(sessao->saida, "   - \"%s\" em %s (sala atual)\n",
+                     mansao->pistas[sala], mansao->nomes[sala]);
+        } else if (mansao->custoPorta != NULL) {
+            escrever(sessao->saida, "   - \"%s\" em %s (custo %lld)\n",
+                     mansao->pistas[sala], mansao->nomes[sala], percurso->distancia[sala]);
+        } else {
+            escrever(sessao->saida, "   - \"%s\" em %s (%lld portas)\n",
+                     mansao->pistas[sala], mansao->nomes[sala], percurso->distancia[sala]);
+        }
+        encontradas++;
+    }
+    if (encontradas == 0) {
+        escrever(sessao->saida, "\n🧭 Nenhuma pista nova ao alcance daqui.\n");
+    }
+}
+
+/*
+ * Função: inserirPista (ou adicionarPista)
+ * Descrição: Cria uma nova versão da árvore de pistas com a pista inserida.
+ *            A versão recebida continua válida e inalterada.
+ * Parâmetros:
+ *   - raiz: ponteiro para a raiz da versão atual
+ *   - pista: string com a pista a ser inserida
+ *   - idPista: id da pista na tabela hash (-1 se não catalogada)
+ * Retorno: raiz da nova versão (uma referência nova, solta com
+ *          liberarArvorePistas); é a própria raiz se a pista já existia
+ */
+PistaNode* inserirPista(PistaNode *raiz, const char *pista, int idPista) {
+    PERFIL_MEDIR(PERFIL_INSERIR_PISTA);
+    PistaNode *novaPista;
+    char chaveLocal[TAMANHO_CHAVE_LOCAL];
+    TextoOrdenado texto;
+    
+    // A chave de ordenação é montada uma vez; a descida só faz memcmp
+    ordenarTexto(&texto, pista, chaveLocal, sizeof(chaveLocal));
+    raiz = diario_inserir(raiz, &texto, &novaPista);
+    if (novaPista != NULL) {
+        PERFIL_ALOCACAO(PERFIL_INSERIR_PISTA);
+        novaPista->idPista = idPista;
+    }
+    soltarTextoOrdenado(&texto, chaveLocal);
+    
+    return raiz;
+}
+
+/*
+ * Função: liberarArvorePistas
+ * Descrição: Solta uma versão da árvore de pistas, liberando apenas os
+ *            nós que nenhuma outra versão compartilha
+ */
+void liberarArvorePistas(PistaNode *raiz) {
+    PERFIL_MEDIR(PERFIL_LIBERAR_PISTAS);
+    int liberados = diario_soltar(raiz);
+    PERFIL_LIBERACAO(PERFIL_LIBERAR_PISTAS, liberados);
+}
+
+/*
+ * Função: calcularPontuacoes
+ * Descrição: Soma o peso das evidências coletadas contra cada suspeito,
+ *            linha a linha do CSR, em uma passada pelos ids das pistas
+ *            do diário, sem comparar strings e sem limite de pistas.
+ *            As somas dão a volta em 32 bits, como no quadro de evidências.
+ * Parâmetros:
+ *   - idsPista: ids no catálogo das pistas do diário (-1: fora dele)
+ *   - totalPistas: tamanho de idsPista
+ *   - hash: ponteiro para a tabela hash (compactada)
+ *   - pontuacao: vetor com uma posição por suspeito (preenchido aqui)
+ * Retorno: void
+ */
+void calcularPontuacoes(const int idsPista[], int totalPistas, const TabelaHash *hash, int pontuacao[]) {
+    PERFIL_MEDIR(PERFIL_CALCULAR_PONTUACOES);
+    unsigned int *soma = (unsigned int*)pontuacao;
+    
+    for (int s = 0; s < hash->totalSuspeitos; s++) {
+        soma[s] = 0;
+    }
+    for (int i = 0; i < totalPistas; i++) {
+        if (idsPista[i] >= 0) {
+            int fim = hash->inicioPista[idsPista[i] + 1];
+            for (int k = hash->inicioPista[idsPista[i]]; k < fim; k++) {
+                soma[hash->suspeitoEvidencia[k]] += (unsigned int)hash->pesoEvidencia[k];
+            }
+        }
+    }
+}
+
+// Pistas catalogadas da árvore com alguma evidência contra o suspeito
+static int contarPistasContra(const PistaNode *raiz, const TabelaHash *hash, int idSuspeito) {
+    int contador = 0;
+    
+    for (; raiz != NULL; raiz = raiz->direita) {
+        contador += contarPistasContra(raiz->esquerda, hash, idSuspeito);
+        if (raiz->idPista < 0) {
+            continue;
+        }
+        for (int k = hash->inicioPista[raiz->idPista]; k < hash->inicioPista[raiz->idPista + 1]; k++) {
+            if (hash->suspeitoEvidencia[k] == idSuspeito) {
+                contador++;
+                break;
+            }
+        }
+    }
+    return contador;
+}
+
+/*
+ * Função: contarPistasPorSuspeito
+ * Descrição: Conta quantas pistas apontam para um suspeito específico
+ * Parâmetros:
+ *   - raiz: ponteiro para a raiz da árvore de pistas
+ *   - hash: ponteiro para a tabela hash (compactada)
+ *   - suspeitoAlvo: nome do suspeito a ser contado
+ * Retorno: número de pistas que apontam para o suspeito
+ */
+int contarPistasPorSuspeito(const PistaNode *raiz, const TabelaHash *hash, const char *suspeitoAlvo) {
+    PERFIL_MEDIR(PERFIL_CONTAR_PISTAS);
+    int idSuspeito = buscarIdSuspeito(hash, suspeitoAlvo);
+    
+    return idSuspeito >= 0 ? contarPistasContra(raiz, hash, idSuspeito) : 0;
+}
+
+/*
+ * Função: montarQuadroEvidencias
+ * Descrição: Fatia em planos de bits o peso das evidências do catálogo
+ *            contra cada suspeito, para cada pista coletável da mansão.
+ *            Pesos repetidos de uma mesma pista e suspeito são somados.
+ *            Com mais de MAX_PISTAS_QUADRO pistas o quadro fica inativo
+ *            e as sessões pontuam pelo CSR.
+ * Parâmetros:
+ *   - mansao: mansão que guarda o quadro
+ *   - hash: tabela hash (compactada) usada pelas sessões
+ * Retorno: void
+ */
+void montarQuadroEvidencias(GrafoMansao *mansao, const TabelaHash *hash) {
+    QuadroEvidencias *quadro = &mansao->quadro;
+    int total = mansao->totalPistas;
+    
+    memset(quadro, 0, sizeof(*quadro));
+    if (total > MAX_PISTAS_QUADRO) {
+        return;
+    }
+    
+    // Id no catálogo de cada pista coletável, pelo texto da primeira sala dela
+    int *idCatalogo = (int*)malloc(sizeof(int) * ((size_t)total + 1));
+    if (idCatalogo == NULL) {
+        printf("Erro ao alocar memória para o quadro de evidências!\n");
+        exit(1);
+    }
+    for (int c = 0; c < total; c++) {
+        idCatalogo[c] = localizarIdPista(hash, mansao->pistas[mansao->salasPista[mansao->inicioSalasPista[c]]]);
+    }
+    
+    // Os pesos somados em 32 bits sem sinal (complemento de dois) dizem quantos
+    // planos são necessários (32 se algum é negativo)
+    uint32_t *somaPeso = (uint32_t*)calloc((size_t)hash->totalSuspeitos + 1, sizeof(uint32_t));
+    if (somaPeso == NULL) {
+        printf("Erro ao alocar memória para o quadro de evidências!\n");
+        exit(1);
+    }
+    uint32_t todosPesos = 0;
+    for (int c = 0; c < total; c++) {
+        if (idCatalogo[c] < 0) {
+            continue;
+        }
+        for (int k = hash->inicioPista[idCatalogo[c]]; k < hash->inicioPista[idCatalogo[c] + 1]; k++) {
+            somaPeso[hash->suspeitoEvidencia[k]] += (uint32_t)hash->pesoEvidencia[k];
+        }
+        for (int k = hash->inicioPista[idCatalogo[c]]; k < hash->inicioPista[idCatalogo[c] + 1]; k++) {
+            todosPesos |= somaPeso[hash->suspeitoEvidencia[k]];
+            somaPeso[hash->suspeitoEvidencia[k]] = 0;
+        }
+    }
+    
+    quadro->ativo = 1;
+    quadro->totalPistas = total;
+    quadro->palavras = (total + 63) / 64;
+    quadro->planos = todosPesos != 0 ? 32 - __builtin_clz(todosPesos) : 0;
+    quadro->totalSuspeitos = hash->totalSuspeitos;
+    quadro->colunas = (hash->totalSuspeitos + LOTE_SUSPEITOS - 1) / LOTE_SUSPEITOS * LOTE_SUSPEITOS;
+    
+    // Planos alinhados: são carregados de 32 em 32 bytes
+    size_t palavrasBits = (size_t)quadro->planos * (size_t)quadro->palavras * (size_t)quadro->colunas;
+    size_t bytesBits = palavrasBits * sizeof(uint64_t);
+    uint64_t *bits = (uint64_t*)aligned_alloc(32, (bytesBits + 31) / 32 * 32 + 32);
+    if (bits == NULL) {
+        printf("Erro ao alocar memória para o quadro de evidências!\n");
+        exit(1);
+    }
+    memset(bits, 0, bytesBits);
+    quadro->memoria = bits;
+    quadro->bits = bits;
+    
+    for (int c = 0; c < total; c++) {
+        if (idCatalogo[c] < 0) {
+            continue;
+        }
+        for (int k = hash->inicioPista[idCatalogo[c]]; k < hash->inicioPista[idCatalogo[c] + 1]; k++) {
+            somaPeso[hash->suspeitoEvidencia[k]] += (uint32_t)hash->pesoEvidencia[k];
+        }
+        for (int k = hash->inicioPista[idCatalogo[c]]; k < hash->inicioPista[idCatalogo[c] + 1]; k++) {
+            int suspeito = hash->suspeitoEvidencia[k];
+            uint32_t peso = somaPeso[suspeito];
+            somaPeso[suspeito] = 0;
+            for (int b = 0; peso != 0; b++, peso >>= 1) {
+                if (peso & 1) {
+                    size_t palavra = ((size_t)b * (size_t)quadro->palavras + (size_t)(c >> 6)) * (size_t)quadro->colunas;
+                    bits[palavra + (size_t)suspeito] |= 1ULL << (c & 63);
+                }
+            }
+        }
+    }
+    
+    free(somaPeso);
+    free(idCatalogo);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/*
+ * Função: pontuarSuspeitosAvx2
+ * Descrição: pontuarSuspeitos com AVX2: quatro suspeitos por vez, com a
+ *            contagem de bits feita por tabela de nibbles (vpshufb) e
+ *            somada por palavra com vpsadbw
+ */
+__attribute__((target("avx2")))
+static void pontuarSuspeitosAvx2(const QuadroEvidencias *quadro, const uint64_t coletadas[], int pontuacao[]) {
+    const __m256i tabela = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t passoPlano = (size_t)quadro->palavras * (size_t)quadro->colunas;
+    
+    for (int s = 0; s < quadro->totalSuspeitos; s += LOTE_SUSPEITOS) {
+        __m256i soma = zero;
+        for (int b = 0; b < quadro->planos; b++) {
+            const uint64_t *plano = quadro->bits + (size_t)b * passoPlano + (size_t)s;
+            __m256i contagem = zero;
+            for (int w = 0; w < quadro->palavras; w++) {
+                if (coletadas[w] == 0) {
+                    continue;
+                }
+                __m256i v = _mm256_and_si256(_mm256_set1_epi64x((long long)coletadas[w]),
+                    _mm256_load_si256((const __m256i*)(plano + (size_t)w * (size_t)quadro->colunas)));
+                __m256i baixo = _mm256_shuffle_epi8(tabela, _mm256_and_si256(v, nibble));
+                __m256i alto = _mm256_shuffle_epi8(tabela, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+                contagem = _mm256_add_epi64(contagem, _mm256_sad_epu8(_mm256_add_epi8(baixo, alto), zero));
+            }
+            contagem = _mm256_sll_epi64(contagem, _mm_cvtsi32_si128(b));
+            soma = b == 31 ? _mm256_sub_epi64(soma, contagem) : _mm256_add_epi64(soma, contagem);
+        }
+        
+        int64_t lote[LOTE_SUSPEITOS];
+        _mm256_storeu_si256((__m256i*)lote, soma);
+        for (int i = 0; i < LOTE_SUSPEITOS && s + i < quadro->totalSuspeitos; i++) {
+            pontuacao[s + i] = (int)(uint32_t)lote[i];
+        }
+    }
+}
+#endif
+
+/*
+ * Função: pontuarSuspeitos
+ * Descrição: Soma o peso das evidências coletadas contra cada suspeito
+ *            pelo quadro de evidências: E lógico entre o diário e cada
+ *            plano, seguido de contagem de bits. Usa AVX2 quando o
+ *            processador tem.
+ * Parâmetros:
+ *   - quadro: quadro de evidências ativo
+ *   - coletadas: diário da sessão como conjunto de bits
+ *   - pontuacao: vetor com uma posição por suspeito (preenchido aqui)
+ * Retorno: void
+ */
+void pontuarSuspeitos(const QuadroEvidencias *quadro, const uint64_t coletadas[], int pontuacao[]) {
+    PERFIL_MEDIR(PERFIL_PONTUAR_SUSPEITOS);
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        pontuarSuspeitosAvx2(quadro, coletadas, pontuacao);
+        return;
+    }
+#endif
+    size_t passoPlano = (size_t)quadro->palavras * (size_t)quadro->colunas;
+    
+    for (int s = 0; s < quadro->totalSuspeitos; s++) {
+        int64_t soma = 0;
+        for (int b = 0; b < quadro->planos; b++) {
+            const uint64_t *plano = quadro->bits + (size_t)b * passoPlano + (size_t)s;
+            int64_t contagem = 0;
+            for (int w = 0; w < quadro->palavras; w++) {
+                contagem += __builtin_popcountll(coletadas[w] & plano[(size_t)w * (size_t)quadro->colunas]);
+            }
+            soma += b == 31 ? -(contagem << 31) : contagem << b;
+        }
+        pontuacao[s] = (int)(uint32_t)soma;
+    }
+}
+
+/*
+ * Função: pontuarDiario
+ * Descrição: Pontua todos os suspeitos pelo diário atual da sessão: pelo
+ *            quadro de evidências quando ativo, senão pelo CSR, com os
+ *            ids das pistas guardados no histórico
+ * Parâmetros:
+ *   - sessao: partida em andamento
+ *   - pontuacao: vetor com uma posição por suspeito (preenchido aqui)
+ * Retorno: void
+ */
+void pontuarDiario(const Sessao *sessao, int pontuacao[]) {
+    const HistoricoDiario *historico = &sessao->historico;
+    
+    if (sessao->mansao->quadro.ativo) {
+        pontuarSuspeitos(&sessao->mansao->quadro, sessao->pistasColetadas, pontuacao);
+    } else {
+        calcularPontuacoes(historico->idsPista + 1, historico->total - 1, sessao->hash, pontuacao);
+    }
+}
+
+/*
+ * Planejador de rotas
+ * Que caminho a partir de uma sala reúne mais evidências contra um
+ * suspeito? A mansão é reduzida à árvore das rotas mais curtas a partir
+ * da entrada (no mapa padrão, a própria árvore E/D), e uma programação
+ * dinâmica das folhas para a raiz resolve todas as salas em O(n):
+ *   melhor[s] = ganho[s] + max(0, maior melhor[f] entre os filhos f)
+ * O ganho de uma sala é o peso da sua pista contra o suspeito, ou zero
+ * se o mesmo texto já está no diário (coletado nela ou em outra sala).
+ * Ainda fora do diário, um texto repetido no caminho conta em cada sala.
+ * Quando o ganho de uma sala muda, só ela e os ancestrais são refeitos,
+ * e a subida para no primeiro cujo melhor não mudou.
+ */
+
+/*
+ * Função: montarArvoreRotas
+ * Descrição: Monta a árvore de rotas da mansão (percurso a partir da
+ *            entrada) e guarda o id no catálogo da pista de cada sala
+ * Parâmetros:
+ *   - mansao: mansão que guarda a árvore
+ *   - hash: tabela hash usada pelas sessões
+ * Retorno: void
+ */
+void montarArvoreRotas(GrafoMansao *mansao, const TabelaHash *hash) {
+    ArvoreRotas *arvore = &mansao->rotas;
+    size_t salas = (size_t)mansao->totalSalas;
+    int *bloco = (int*)malloc(sizeof(int) * (5 * salas + 1));
+    Percurso percurso = { .memoria = NULL };
+    int sala;
+    
+    if (bloco == NULL) {
+        printf("Erro ao alocar memória para a árvore de rotas!\n");
+        exit(1);
+    }
+    int *ordem = bloco;
+    int *pai = ordem + salas;
+    int *inicioFilhos = pai + salas;
+    int *filhos = inicioFilhos + salas + 1;
+    int *pistaCatalogo = filhos + salas;
+    int totalOrdem = 0;
+    
+    iniciarPercurso(&percurso, mansao, mansao->entrada);
+    while ((sala = proximaSalaPercurso(&percurso)) >= 0) {
+        ordem[totalOrdem++] = sala;
+    }
+    for (size_t s = 0; s < salas; s++) {
+        pai[s] = -1;
+        inicioFilhos[s] = 0;
+        pistaCatalogo[s] = mansao->pistas[s][0] != '\0' ? localizarIdPista(hash, mansao->pistas[s]) : -1;
+    }
+    for (int i = 1; i < totalOrdem; i++) {
+        int filho = ordem[i];
+        pai[filho] = percurso.anterior[filho];
+        inicioFilhos[pai[filho]]++;
+    }
+    liberarPercurso(&percurso);
+    
+    // Contagem acumulada: inicioFilhos[s] marca o fim dos filhos de s, e
+    // a distribuição de trás para frente o recua até o início, mantendo
+    // os filhos na ordem do percurso
+    int acumulado = 0;
+    for (size_t s = 0; s < salas; s++) {
+        acumulado += inicioFilhos[s];
+        inicioFilhos[s] = acumulado;
+    }
+    inicioFilhos[salas] = acumulado;
+    for (int i = totalOrdem - 1; i >= 1; i--) {
+        int filho = ordem[i];
+        filhos[--inicioFilhos[pai[filho]]] = filho;
+    }
+    
+    arvore->memoria = bloco;
+    arvore->ordem = ordem;
+    arvore->totalOrdem = totalOrdem;
+    arvore->pai = pai;
+    arvore->inicioFilhos = inicioFilhos;
+    arvore->filhos = filhos;
+    arvore->pistaCatalogo = pistaCatalogo;
+}
+
+/*
+ * Função: ganhoDaSala
+ * Descrição: Peso da pista de uma sala contra um suspeito
+ */
+long long ganhoDaSala(const ArvoreRotas *arvore, const TabelaHash *hash, int suspeito, int sala) {
+    int pista = arvore->pistaCatalogo[sala];
+    long long ganho = 0;
+    
+    if (pista >= 0) {
+        for (int k = hash->inicioPista[pista]; k < hash->inicioPista[pista + 1]; k++) {
+            if (hash->suspeitoEvidencia[k] == suspeito) {
+                ganho += hash->pesoEvidencia[k];
+            }
+        }
+    }
+    return ganho;
+}
+
+// Refaz melhor e seguinte de uma sala a partir dos filhos; retorna o melhor
+static long long refazerSalaPlano(const ArvoreRotas *arvore, PlanoSuspeito *plano, int sala) {
+    long long continuar = 0;
+    int seguinte = -1;
+    
+    for (int i = arvore->inicioFilhos[sala]; i < arvore->inicioFilhos[sala + 1]; i++) {
+        int filho = arvore->filhos[i];
+        if (plano->melhor[filho] > continuar) {
+            continuar = plano->melhor[filho];
+            seguinte = filho;
+        }
+    }
+    plano->seguinte[sala] = seguinte;
+    return plano->melhor[sala] = plano->ganho[sala] + continuar;
+}
+
+/*
+ * Função: planejarSuspeito
+ * Descrição: Calcula, em uma passada das folhas para a raiz, o melhor
+ *            caminho descendo de cada sala contra um suspeito
+ * Parâmetros:
+ *   - plano: plano a preencher (a memória é alocada na primeira vez)
+ *   - mansao: mansão com a árvore de rotas montada
+ *   - hash: tabela hash da árvore de rotas
+ *   - suspeito: id do suspeito
+ *   - estadoSalas: estado de visita de uma sessão; as salas cuja pista
+ *     já foi coletada, nelas ou em outra sala com o mesmo texto, não
+ *     contam (NULL: todas contam)
+ * Retorno: void
+ */
+void planejarSuspeito(PlanoSuspeito *plano, const GrafoMansao *mansao, const TabelaHash *hash,
+                      int suspeito, const unsigned char estadoSalas[]) {
+    const ArvoreRotas *arvore = &mansao->rotas;
+    size_t salas = (size_t)mansao->totalSalas;
+    
+    if (plano->memoria == NULL) {
+        plano->memoria = malloc(salas * (2 * sizeof(long long) + sizeof(int)));
+        if (plano->memoria == NULL) {
+            printf("Erro ao alocar memória para o plano!\n");
+            exit(1);
+        }
+        plano->ganho = (long long*)plano->memoria;
+        plano->melhor = plano->ganho + salas;
+        plano->seguinte = (int*)(plano->melhor + salas);
+    }
+    plano->suspeito = suspeito;
+    
+    for (int i = 0; i < arvore->totalOrdem; i++) {
+        int sala = arvore->ordem[i];
+        plano->ganho[sala] = ganhoDaSala(arvore, hash, suspeito, sala);
+    }
+    
+    // Uma pista coletada em qualquer sala zera o ganho de todas as salas
+    // com o mesmo texto
+    if (estadoSalas != NULL) {
+        for (int pista = 0; pista < mansao->totalPistas; pista++) {
+            int inicio = mansao->inicioSalasPista[pista];
+            int fim = mansao->inicioSalasPista[pista + 1];
+            int coletada = 0;
+            for (int i = inicio; i < fim && !coletada; i++) {
+                coletada = estadoSalas[mansao->salasPista[i]] == SALA_PISTA_COLETADA;
+            }
+            for (int i = inicio; coletada && i < fim; i++) {
+                plano->ganho[mansao->salasPista[i]] = 0;
+            }
+        }
+    }
+    
+    for (int i = arvore->totalOrdem - 1; i >= 0; i--) {
+        refazerSalaPlano(arvore, plano, arvore->ordem[i]);
+    }
+}
+
+/*
+ * Função: ajustarGanhoPlano
+ * Descrição: Troca o ganho de uma sala e refaz o plano dela para cima,
+ *            até o primeiro ancestral cujo melhor não muda
+ * Parâmetros:
+ *   - plano: plano já calculado
+ *   - mansao: mansão do plano
+ *   - sala: sala cujo ganho mudou
+ *   - ganho: novo ganho
+ * Retorno: void
+ */
+void ajustarGanhoPlano(PlanoSuspeito *plano, const GrafoMansao *mansao, int sala, long long ganho) {
+    const ArvoreRotas *arvore = &mansao->rotas;
+    
+    plano->ganho[sala] = ganho;
+    while (sala >= 0) {
+        long long antes = plano->melhor[sala];
+        if (refazerSalaPlano(arvore, plano, sala) == antes) {
+            break;
+        }
+        sala = arvore->pai[sala];
+    }
+}
+
+void liberarPlano(PlanoSuspeito *plano) {
+    free(plano->memoria);
+    plano->memoria = NULL;
+}
+
+/*
+ * Função: escreverRotaPlano
+ * Descrição: Escreve as salas do melhor caminho a partir de uma sala
+ *            (até MAX_SALAS_DICA, com o total das demais) e a última
+ * Retorno: última sala do caminho
+ */
+int escreverRotaPlano(Saida *saida, const GrafoMansao *mansao, const PlanoSuspeito *plano, int sala) {
+    int escritas = 0, omitidas = 0;
+    
+    for (;;) {
+        if (escritas < MAX_SALAS_DICA) {
+            escrever(saida, escritas > 0 ? " → %s" : "%s", mansao->nomes[sala]);
+            escritas++;
+        } else {
+            omitidas++;
+        }
+        if (plano->seguinte[sala] < 0) {
+            break;
+        }
+        sala = plano->seguinte[sala];
+    }
+    if (omitidas > 0) {
+        escrever(saida, " → ... (+%d salas) → %s", omitidas - 1, mansao->nomes[sala]);
+    }
+    escrever(saida, "\n");
+    return sala;
+}
+
+// Mantém o plano da dica (se já calculado) em dia com uma pista que
+// entrou no diário ou saiu dele, em todas as salas com o mesmo texto
+static void atualizarDica(Sessao *sessao, int pista, int coletada) {
+    const GrafoMansao *mansao = sessao->mansao;
+    PlanoSuspeito *plano = &sessao->dica;
+    
+    if (plano->memoria == NULL) {
+        return;
+    }
+    for (int i = mansao->inicioSalasPista[pista]; i < mansao->inicioSalasPista[pista + 1]; i++) {
+        int sala = mansao->salasPista[i];
+        long long ganho = coletada ? 0 : ganhoDaSala(&mansao->rotas, sessao->hash, plano->suspeito, sala);
+        ajustarGanhoPlano(plano, mansao, sala, ganho);
+    }
+}
+
+/*
+ * Função: exibirDica
+ * Descrição: Mostra o caminho que reúne mais evidências ainda fora do
+ *            diário contra o suspeito que lidera o diário (comando H).
+ *            O plano é calculado no primeiro pedido e, depois, só
+ *            ajustado a cada pista coletada ou desfeita.
+ * Parâmetros:
+ *   - sessao: partida em exploração
+ * Retorno: void
+ */
+void exibirDica(Sessao *sessao) {
+    const TabelaHash *hash = sessao->hash;
+    const GrafoMansao *mansao = sessao->mansao;
+    Saida *saida = sessao->saida;
+    PlanoSuspeito *plano = &sessao->dica;
+    int pontuacaoLocal[MAX_SUSPEITOS];
+    int *pontuacao = pontuacaoLocal;
+    int lider = -1;
+    
+    if (hash->totalSuspeitos > MAX_SUSPEITOS) {
+        pontuacao = (int*)malloc(sizeof(int) * (size_t)hash->totalSuspeitos);
+        if (pontuacao == NULL) {
+            printf("Erro ao alocar memória para pontuação!\n");
+            exit(1);
+        }
+    }
+    pontuarDiario(sessao, pontuacao);
+    for (int s = 0; s < hash->totalSuspeitos; s++) {
+        if (pontuacao[s] > 0 && (lider < 0 || pontuacao[s] > pontuacao[lider])) {
+            lider = s;
+        }
+    }
+    if (pontuacao != pontuacaoLocal) {
+        free(pontuacao);
+    }
+    
+    if (lider < 0) {
+        escrever(saida, "\n💡 Colete alguma pista primeiro: a dica segue o suspeito que o diário aponta.\n");
+        return;
+    }
+    if (plano->memoria == NULL || plano->suspeito != lider) {
+        planejarSuspeito(plano, mansao, hash, lider, sessao->estadoSalas);
+    }
+    
+    int sala = sessao->salaAtual;
+    if (plano->melhor[sala] > 0) {
+        escrever(saida, "\n💡 Mais evidências contra %s a partir daqui (peso +%lld):\n   ",
+                 hash->suspeitos[lider], plano->melhor[sala]);
+        escreverRotaPlano(saida, mansao, plano, sala);
+    } else if (plano->melhor[mansao->entrada] > 0) {
+        escrever(saida, "\n💡 Nada mais contra %s adiante. Melhor rota desde a entrada (peso +%lld):\n   ",
+                 hash->suspeitos[lider], plano->melhor[mansao->entrada]);
+        escreverRotaPlano(saida, mansao, plano, mansao->entrada);
+    } else {
+        escrever(saida, "\n💡 Nenhuma pista fora do diário pesa contra %s.\n", hash->suspeitos[lider]);
+    }
+}
+
+/*
+ * Função: exibirPlanos
+ * Descrição: Para cada suspeito, a rota desde a entrada que reúne mais
+ *            evidências contra ele, com o goto que a percorre (--planejar)
+ * Parâmetros:
+ *   - mansao: mansão com a árvore de rotas montada
+ *   - hash: tabela hash da árvore de rotas
+ * Retorno: void
+ */
+void exibirPlanos(const GrafoMansao *mansao, const TabelaHash *hash) {
+    Saida saida = { .arquivo = stdout };
+    PlanoSuspeito plano = { .memoria = NULL };
+    
+    printf("🧭 Rotas com mais evidências desde %s:\n", mansao->nomes[mansao->entrada]);
+    for (int s = 0; s < hash->totalSuspeitos; s++) {
+        planejarSuspeito(&plano, mansao, hash, s, NULL);
+        if (plano.melhor[mansao->entrada] <= 0) {
+            printf("\n   %s: nenhuma rota reúne evidências\n", hash->suspeitos[s]);
+            continue;
+        }
+        printf("\n   %s (peso %lld):\n      ", hash->suspeitos[s], plano.melhor[mansao->entrada]);
+        int ultima = escreverRotaPlano(&saida, mansao, &plano, mansao->entrada);
+        if (ultima != mansao->entrada) {
+            printf("      goto %s\n", mansao->nomes[ultima]);
+        }
+    }
+    liberarPlano(&plano);
+}
+
+/*
+ * Função: exibirPistasComSuspeitos
+ * Descrição: Exibe todas as pistas coletadas com seus respectivos suspeitos
+ * Parâmetros:
+ *   - raiz: ponteiro para a raiz da árvore de pistas
+ *   - hash: ponteiro para a tabela hash (compactada)
+ *   - saida: destino do texto
+ * Retorno: void
+ */
+void exibirPistasComSuspeitos(const PistaNode *raiz, const TabelaHash *hash, Saida *saida) {
+    if (raiz == NULL) {
+        return;
+    }
+    
+    exibirPistasComSuspeitos(raiz->esquerda, hash, saida);
+    
+    escrever(saida, "  📋 \"%s\"\n", raiz->pista);
+    if (raiz->idPista >= 0) {
+        int inicio = hash->inicioPista[raiz->idPista];
+        int fim = hash->inicioPista[raiz->idPista + 1];
+        
+        for (int k = inicio; k < fim; k++) {
+            const char *suspeito = hash->suspeitos[hash->suspeitoEvidencia[k]];
+            if (hash->pesoEvidencia[k] == 1) {
+                escrever(saida, "     ➜ Aponta para: %s\n", suspeito);
+            } else {
+                escrever(saida, "     ➜ Aponta para: %s (peso %d)\n", suspeito, hash->pesoEvidencia[k]);
+            }
+        }
+        if (fim > inicio) {
+            escrever(saida, "\n");
+        }
+    }
+    
+    exibirPistasComSuspeitos(raiz->direita, hash, saida);
+}
+
+static LeitorEntrada entrada;
+
+/*
+ * Função: preencherEntrada
+ * Descrição: Move os bytes pendentes para o início do buffer e lê da
+ *            entrada padrão tudo o que couber em uma única chamada
+ * Retorno: quantidade de bytes lidos (0 no fim da entrada)
+ */
+size_t preencherEntrada(void) {
+    if (entrada.inicio > 0) {
+        memmove(entrada.dados, entrada.dados + entrada.inicio, entrada.fim - entrada.inicio);
+        entrada.fim -= entrada.inicio;
+        entrada.inicio = 0;
+    }
+    
+    if (entrada.fimArquivo || entrada.fim == sizeof(entrada.dados)) {
+        return 0;
+    }
+    
+    ssize_t lidos = read(STDIN_FILENO, entrada.dados + entrada.fim, sizeof(entrada.dados) - entrada.fim);
+    if (lidos <= 0) {
+        entrada.fimArquivo = 1;
+        return 0;
+    }
+    
+    entrada.fim += (size_t)lidos;
+    return (size_t)lidos;
+}
+
+/*
+ * Função: lerLinha
+ * Descrição: Lê a próxima linha da entrada, sem o \n (e \r) final.
+ *            Linhas maiores que o destino são truncadas.
+ * Parâmetros:
+ *   - destino: buffer que recebe a linha
+ *   - tamanho: capacidade do buffer
+ * Retorno: 1 se leu uma linha, 0 no fim da entrada
+ */
+int lerLinha(char *destino, size_t tamanho) {
+    char *quebra;
+    
+    // Garante uma linha completa no buffer (ou o resto da entrada)
+    while ((quebra = memchr(entrada.dados + entrada.inicio, '\n', entrada.fim - entrada.inicio)) == NULL) {
+        if (preencherEntrada() == 0) {
+            break;
+        }
+    }
+    
+    size_t tamanhoLinha = quebra != NULL ? (size_t)(quebra - (entrada.dados + entrada.inicio))
+                                         : entrada.fim - entrada.inicio;
+    if (quebra == NULL && tamanhoLinha == 0) {
+        return 0;
+    }
+    
+    size_t copiar = tamanhoLinha < tamanho - 1 ? tamanhoLinha : tamanho - 1;
+    memcpy(destino, entrada.dados + entrada.inicio, copiar);
+    if (copiar > 0 && destino[copiar - 1] == '\r') {
+        copiar--;
+    }
+    destino[copiar] = '\0';
+    
+    entrada.inicio += tamanhoLinha + (quebra != NULL);
+    return 1;
+}
+
+/*
+ * Função: enfileirarMovimento
+ * Descrição: Acrescenta um movimento ao fim da fila
+ * Parâmetros:
+ *   - fila: ponteiro para a fila de movimentos
+ *   - movimento: caractere do comando (E, D, S...) ou MOVIMENTO_PORTA
+ * Retorno: void
+ */
+void enfileirarMovimento(FilaMovimentos *fila, int movimento) {
+    reservarMovimentos(fila, 1);
+    fila->movimentos[(fila->inicio + fila->total) % fila->capacidade] = movimento;
+    fila->total++;
+}
+
+/*
+ * Função: proximoMovimento
+ * Descrição: Retira o primeiro movimento da fila (que não pode estar vazia)
+ * Parâmetros:
+ *   - fila: ponteiro para a fila de movimentos
+ * Retorno: caractere do movimento ou MOVIMENTO_PORTA
+ */
+int proximoMovimento(FilaMovimentos *fila) {
+    int movimento = fila->movimentos[fila->inicio];
+    fila->inicio = (fila->inicio + 1) % fila->capacidade;
+    fila->total--;
+    return movimento;
+}
+
+/*
+ * Função: exibirPaginaDiario
+ * Descrição: Mostra uma página de uma versão do diário (comandos "diario"
+ *            e "versao"). O argumento é o número da página, de
+ *            PISTAS_POR_PAGINA pistas (a primeira se vazio), ou um texto:
+ *            a página começa na primeira pista que não vem antes dele na
+ *            ordem alfabética (sem diferenciar maiúsculas e acentos).
+ *            Posição e página saem dos tamanhos das subárvores, sem
+ *            percorrer o diário.
+ * Parâmetros:
+ *   - sessao: partida em exploração
+ *   - diario: versão do diário a mostrar
+ *   - argumento: o que vem depois do comando
+ * Retorno: void
+ */
+void exibirPaginaDiario(Sessao *sessao, const PistaNode *diario, const char *argumento) {
+    const PistaNode *pagina[PISTAS_POR_PAGINA];
+    Saida *saida = sessao->saida;
+    int total = diario_contar(diario);
+    long long inicio = 0;
+    
+    while (*argumento == ' ') {
+        argumento++;
+    }
+    if (*argumento >= '0' && *argumento <= '9' && strspn(argumento, "0123456789") == strlen(argumento)) {
+        long long numero = 0;
+        for (const char *c = argumento; *c != '\0' && numero <= total; c++) {
+            numero = 10 * numero + (*c - '0');
+        }
+        inicio = numero > 1 ? (numero - 1) * PISTAS_POR_PAGINA : 0;
+    } else if (*argumento != '\0') {
+        char chaveLocal[TAMANHO_CHAVE_LOCAL];
+        TextoOrdenado texto;
+        ordenarTexto(&texto, argumento, chaveLocal, sizeof(chaveLocal));
+        inicio = diario_posicao(diario, &texto);
+        soltarTextoOrdenado(&texto, chaveLocal);
+    }
+    
+    if (total == 0) {
+        escrever(saida, "\n📖 O diário ainda está vazio.\n");
+    } else if (inicio >= total) {
+        escrever(saida, "\n📖 O diário tem só %d pista(s); nada a mostrar a partir daí.\n", total);
+    } else {
+        int quantidade = diario_pagina(diario, (int)inicio, PISTAS_POR_PAGINA, pagina);
+        escrever(saida, "\n📖 Diário: pistas %lld a %lld de %d\n", inicio + 1, inicio + quantidade, total);
+        for (int i = 0; i < quantidade; i++) {
+            escrever(saida, "   %lld. %s\n", inicio + i + 1, pagina[i]->pista);
+        }
+    }
+    escrever(saida, "\nSua escolha: ");
+}
+
+/*
+ * Função: exibirVersaoDiario
+ * Descrição: Mostra o diário como estava numa versão anterior (comando
+ *            "versao <n> [página]"): a versão n é o diário depois da
+ *            n-ésima pista coletada, e a 0, o diário inicial. Só consulta
+ *            o histórico; a partida continua na versão atual.
+ * Parâmetros:
+ *   - sessao: partida em exploração
+ *   - argumento: o que vem depois de "versao"
+ * Retorno: void
+ */
+void exibirVersaoDiario(Sessao *sessao, const char *argumento) {
+    const HistoricoDiario *historico = &sessao->historico;
+    const GrafoMansao *mansao = sessao->mansao;
+    int atual = historico->total - 1;
+    long long versao = 0;
+    
+    while (*argumento == ' ') {
+        argumento++;
+    }
+    const char *fim = argumento;
+    for (; *fim >= '0' && *fim <= '9'; fim++) {
+        if (versao <= atual) {
+            versao = 10 * versao + (*fim - '0');
+        }
+    }
+    if (fim == argumento || (*fim != '\0' && *fim != ' ') || versao > atual) {
+        escrever(sessao->saida, "\n❌ Use versao <n>, com n de 0 a %d (pistas coletadas até agora).\n", atual);
+        escrever(sessao->saida, "\nSua escolha: ");
+        return;
+    }
+    
+    int n = (int)versao;
+    if (n == 0) {
+        escrever(sessao->saida, "\n🕰️  Versão 0 de %d: o diário antes da primeira pista\n", atual);
+    } else {
+        escrever(sessao->saida, "\n🕰️  Versão %d de %d: depois de \"%s\", coletada em %s\n",
+                 n, atual, historico->pistas[n], mansao->nomes[historico->salas[n]]);
+    }
+    exibirPaginaDiario(sessao, historico->versoes[n], fim);
+}
+
+/*
+ * Função: interpretarComando
+ * Descrição: Enfileira os movimentos de uma linha de comando.
+ *            Aceita vários movimentos por linha ("EED", "3 1"), em que
+ *            números escolhem portas numeradas, ou "goto <sala>", que
+ *            enfileira a rota mais curta até a sala. "diario [página]"
+ *            e "versao <n> [página]" só mostram o diário (o atual ou
+ *            uma versão anterior) e não enfileiram nada.
+ * Parâmetros:
+ *   - sessao: partida em exploração
+ *   - linha: comando recebido
+ * Retorno: void (a fila continua vazia se a linha não tinha movimentos)
+ */
+void interpretarComando(Sessao *sessao, const char *linha) {
+    const GrafoMansao *mansao = sessao->mansao;
+    FilaMovimentos *fila = &sessao->fila;
+    
+    if (strncasecmp(linha, "diario", 6) == 0 && (linha[6] == '\0' || linha[6] == ' ')) {
+        exibirPaginaDiario(sessao, sessao->historico.versoes[sessao->historico.total - 1], linha + 6);
+        return;
+    }
+    if (strncasecmp(linha, "versao", 6) == 0 && (linha[6] == '\0' || linha[6] == ' ')) {
+        exibirVersaoDiario(sessao, linha + 6);
+        return;
+    }
+    if (strncasecmp(linha, "goto ", 5) == 0) {
+        const char *destino = linha + 5;
+        const SalaNode *sala = salas_buscar(&mansao->indice, destino);
+        
+        if (sala == NULL) {
+            escrever(sessao->saida, "\n❌ Sala \"%s\" não encontrada!\n", destino);
+        } else if (sala->id == sessao->salaAtual) {
+            escrever(sessao->saida, "\n📍 Você já está em %s.\n", mansao->nomes[sessao->salaAtual]);
+        } else if (buscarRota(&sessao->percurso, mansao, sessao->salaAtual, sala->id, fila) < 0) {
+            escrever(sessao->saida, "\n❌ Não há caminho daqui até %s!\n", mansao->nomes[sala->id]);
+        } else {
+            return;
+        }
+        escrever(sessao->saida, "\nSua escolha: ");
+        return;
+    }
+    
+    for (const char *c = linha; *c != '\0'; c++) {
+        int movimento = (unsigned char)*c;
+        if (*c == ' ' || *c == '\t') {
+            continue;
+        }
+        if (*c >= '1' && *c <= '9') {
+            // Número da porta (1 = primeira); números grandes demais viram
+            // uma porta que não existe
+            long long numero = 0;
+            for (; *c >= '0' && *c <= '9'; c++) {
+                if (numero < INT_MAX / 2) {
+                    numero = 10 * numero + (*c - '0');
+                }
+            }
+            c--;
+            movimento = MOVIMENTO_PORTA(numero < INT_MAX / 2 ? (int)numero - 1 : INT_MAX / 2);
+        }
+        enfileirarMovimento(fila, movimento);
+    }
+}
+
+/*
+ * Função: registrarVersao
+ * Descrição: Acrescenta uma versão ao histórico do diário. Com os vetores
+ *            cheios, a capacidade dobra; as versões antigas continuam lá.
+ * Parâmetros:
+ *   - historico: ponteiro para o histórico
+ *   - versao: raiz da nova versão (o histórico assume a referência)
+ *   - pista: pista que originou a versão
+ *   - idPista: id da pista no catálogo (-1 se fora dele)
+ *   - idSala: sala onde a pista foi coletada
+ * Retorno: void
+ */
+void registrarVersao(HistoricoDiario *historico, PistaNode *versao, const char *pista, int idPista, int idSala) {
+    if (historico->total == historico->capacidade) {
+        size_t capacidade = 2 * (size_t)historico->capacidade;
+        size_t total = (size_t)historico->total;
+        PistaNode **versoes = (PistaNode**)malloc(capacidade * (sizeof(PistaNode*) + sizeof(const char*)
+                                                               + 2 * sizeof(int)));
+        if (versoes == NULL) {
+            printf("Erro ao alocar memória para o histórico do diário!\n");
+            exit(1);
+        }
+        const char **pistas = (const char**)(versoes + capacidade);
+        int *idsPista = (int*)(pistas + capacidade);
+        int *salas = idsPista + capacidade;
+        memcpy(versoes, historico->versoes, total * sizeof(PistaNode*));
+        memcpy(pistas, historico->pistas, total * sizeof(const char*));
+        memcpy(idsPista, historico->idsPista, total * sizeof(int));
+        memcpy(salas, historico->salas, total * sizeof(int));
+        free(historico->memoria);
+        historico->memoria = versoes;
+        historico->versoes = versoes;
+        historico->pistas = pistas;
+        historico->idsPista = idsPista;
+        historico->salas = salas;
+        historico->capacidade = (int)capacidade;
+    }
+    historico->versoes[historico->total] = versao;
+    historico->pistas[historico->total] = pista;
+    historico->idsPista[historico->total] = idPista;
+    historico->salas[historico->total] = idSala;
+    historico->total++;
+}
+
+/*
+ * Função: desfazerVersao
+ * Descrição: Descarta a versão mais recente do diário, voltando à anterior.
+ *            Todas as salas com o texto da pista removida (não só a da
+ *            coleta) voltam a constar como não visitadas, para que a
+ *            pista possa ser coletada de novo em qualquer uma delas.
+ * Parâmetros:
+ *   - sessao: partida em exploração
+ * Retorno: pista removida (ou NULL se não há o que desfazer)
+ */
+const char* desfazerVersao(Sessao *sessao) {
+    HistoricoDiario *historico = &sessao->historico;
+    const GrafoMansao *mansao = sessao->mansao;
+    
+    if (historico->total <= 1) {
+        return NULL;
+    }
+    historico->total--;
+    liberarArvorePistas(historico->versoes[historico->total]);
+    
+    int sala = historico->salas[historico->total];
+    int pista = mansao->pistaDaSala[sala];
+    marcarPistaColetada(sessao, sala, 0);
+    for (int i = mansao->inicioSalasPista[pista]; i < mansao->inicioSalasPista[pista + 1]; i++) {
+        int outra = mansao->salasPista[i];
+        if (sessao->estadoSalas[outra] == SALA_PISTA_COLETADA) {
+            sessao->estadoSalas[outra] = SALA_NAO_VISITADA;
+        }
+    }
+    atualizarDica(sessao, pista, 0);
+    return historico->pistas[historico->total];
+}
+
+/*
+ * Função: acrescentarNaTrilha
+ * Descrição: Põe uma sala (que ainda não está na trilha) no fim dela,
+ *            trocando o vetor local por um alocado quando ele enche
+ * Parâmetros:
+ *   - trilha: trilha da sessão
+ *   - sala: sala a acrescentar
+ * Retorno: void
+ */
+void acrescentarNaTrilha(Trilha *trilha, int sala) {
+    if (trilha->total == trilha->capacidade) {
+        int *salas = (int*)malloc(sizeof(int) * 2 * (size_t)trilha->capacidade);
+        if (salas == NULL) {
+            printf("Erro ao alocar memória para a trilha!\n");
+            exit(1);
+        }
+        memcpy(salas, trilha->salas, sizeof(int) * (size_t)trilha->total);
+        if (trilha->salas != trilha->salasLocal) {
+            free(trilha->salas);
+        }
+        trilha->salas = salas;
+        trilha->capacidade *= 2;
+    }
+    trilha->salas[trilha->total++] = sala;
+    trilha->naTrilha[sala] = 1;
+}
+
+// Acrescenta ao resumo as pistas do diário, na ordem em que ele as exibe
+static void misturarDiarioResumo(Sessao *sessao, const PistaNode *raiz) {
+    for (; raiz != NULL; raiz = raiz->direita) {
+        misturarDiarioResumo(sessao, raiz->esquerda);
+        misturarResumo(sessao, hashFiltro(raiz->pista));
+    }
+}
+
+/*
+ * Função: encerrarSessao
+ * Descrição: Exibe o encerramento do jogo e solta o diário da partida
+ * Parâmetros:
+ *   - sessao: partida a encerrar
+ * Retorno: void
+ */
+void encerrarSessao(Sessao *sessao) {
+    escrever(sessao->saida, "\n==============================================\n");
+    escrever(sessao->saida, "   Obrigado por jogar Detective Quest!\n");
+    escrever(sessao->saida, "==============================================\n");
+    
+    int pistas = diario_contar(sessao->arvorePistas);
+    misturarDiarioResumo(sessao, sessao->arvorePistas);
+    liberarArvorePistas(sessao->arvorePistas);
+    sessao->arvorePistas = NULL;
+    sessao->fase = FASE_ENCERRADA;
+    misturarResumo(sessao, (uint64_t)pistas);
+}
+
+/*
+ * Função: iniciarJulgamento
+ * Descrição: Encerra a exploração, fixa o diário final e pede a acusação
+ *            (ou encerra a partida, se nenhuma pista foi coletada)
+ * Parâmetros:
+ *   - sessao: partida em exploração
+ * Retorno: void
+ */
+void iniciarJulgamento(Sessao *sessao) {
+    HistoricoDiario *historico = &sessao->historico;
+    Saida *saida = sessao->saida;
+    
+    // Guarda a versão final e solta as demais (nós compartilhados ficam)
+    // As versões são soltas, mas o histórico continua com os ids das
+    // pistas, que pontuam a acusação
+    sessao->arvorePistas = diario_reter(historico->versoes[historico->total - 1]);
+    for (int i = 0; i < historico->total; i++) {
+        liberarArvorePistas(historico->versoes[i]);
+        historico->versoes[i] = NULL;
+    }
+    
+    escrever(saida, "\n==============================================\n");
+    escrever(saida, "        ⚖️  FASE DE JULGAMENTO  ⚖️\n");
+    escrever(saida, "==============================================\n");
+    
+    if (sessao->arvorePistas == NULL) {
+        escrever(saida, "\n❌ Você não coletou pistas suficientes!\n");
+        escrever(saida, "   O caso permanece sem solução.\n");
+        encerrarSessao(sessao);
+        return;
+    }
+    
+    escrever(saida, "\n📂 Pistas coletadas e suspeitos relacionados:\n\n");
+    exibirPistasComSuspeitos(sessao->arvorePistas, sessao->hash, saida);
+    
+    escrever(saida, "==============================================\n");
+    escrever(saida, "\nCom base nas evidências, quem você acusa?\n");
+    escrever(saida, "Digite o nome completo do suspeito: ");
+    sessao->fase = FASE_ACUSANDO;
+}
+
+/*
+ * Função: explorarSalas
+ * Descrição: Controla a navegação pela mansão e o sistema de coleta de
+ *            pistas. Executa os movimentos da fila e, quando ela esvazia,
+ *            exibe o menu e retorna para aguardar o próximo comando.
+ *            Cada movimento custa O(portas da sala atual).
+ * Parâmetros:
+ *   - sessao: partida em exploração
+ * Retorno: void
+ */
+void explorarSalas(Sessao *sessao) {
+    PERFIL_MEDIR(PERFIL_EXPLORAR_SALAS);
+    const TabelaHash *hash = sessao->hash;
+    const GrafoMansao *mansao = sessao->mansao;
+    HistoricoDiario *historico = &sessao->historico;
+    Trilha *trilha = &sessao->trilha;
+    FilaMovimentos *fila = &sessao->fila;
+    Saida *saida = sessao->saida;
+    int proxima;
+    int escolha;
+    
+    for (;;) {
+        int salaAtual = sessao->salaAtual;
+        int primeiraPorta = mansao->inicioPortas[salaAtual];
+        int fimPortas = mansao->inicioPortas[salaAtual + 1];
+        
+        // A sala é descrita (e a pista coletada) só ao entrar nela
+        if (sessao->entrouNaSala) {
+            sessao->entrouNaSala = 0;
+            misturarResumo(sessao, (uint64_t)salaAtual);
+            escrever(saida, "\n================================================\n");
+            escrever(saida, "📍 Localização: %s\n", mansao->nomes[salaAtual]);
+            escrever(saida, "================================================\n");
+            
+            // Em uma sala já visitada o resultado é conhecido: nada a buscar
+            if (sessao->estadoSalas[salaAtual] == SALA_PISTA_COLETADA) {
+                escrever(saida, "\n   ✓ A pista desta sala já está no diário.\n");
+            } else if (sessao->estadoSalas[salaAtual] == SALA_SEM_PISTA) {
+                escrever(saida, "\n   Nenhuma pista encontrada aqui.\n");
+            } else {
+                // Verifica se há pista nesta sala
+                const char *pista = mansao->pistas[salaAtual];
+                
+                if (pista[0] != '\0') {
+                    escrever(saida, "\n🔍 PISTA ENCONTRADA!\n");
+                    escrever(saida, "   \"%s\"\n", pista);
+                    
+                    PistaNode *atual = historico->versoes[historico->total - 1];
+                    int idPista = buscarIdPista(hash, pista);
+                    PistaNode *nova = inserirPista(atual, pista, idPista);
+                    if (nova != atual) {
+                        registrarVersao(historico, nova, pista, idPista, salaAtual);
+                        marcarPistaColetada(sessao, salaAtual, 1);
+                        misturarResumo(sessao, RESUMO_COLETA | (uint64_t)diario_contar(nova));
+                    } else {
+                        liberarArvorePistas(nova);  // Já estava no diário
+                    }
+                    sessao->estadoSalas[salaAtual] = SALA_PISTA_COLETADA;
+                    atualizarDica(sessao, mansao->pistaDaSala[salaAtual], 1);
+                    
+                    escrever(saida, "\n   ✓ Pista registrada no diário\n");
+                } else {
+                    sessao->estadoSalas[salaAtual] = SALA_SEM_PISTA;
+                    escrever(saida, "\n   Nenhuma pista encontrada aqui.\n");
+                }
+            }
+        }
+        
+        // Sem movimentos pendentes: mostra o menu e aguarda o comando
+        if (fila->total == 0) {
+            int anterior = trilha->total > 1 ? trilha->salas[trilha->total - 2] : -1;
+            int temEsquerda = 0, temDireita = 0, numeradas = 0, saidas = 0;
+            for (int p = primeiraPorta; p < fimPortas; p++) {
+                temEsquerda |= mansao->rotuloPorta[p] == 'E';
+                temDireita |= mansao->rotuloPorta[p] == 'D';
+                numeradas += mansao->rotuloPorta[p] == PORTA_NUMERADA;
+                saidas += mansao->destinoPorta[p] != anterior;
+            }
+            
+            if (saidas == 0) {
+                escrever(saida, "\n⚠️  Beco sem saída! Use [V] para voltar ou [S] para revisar as pistas.\n");
+            }
+            
+            escrever(saida, "\n--- Opções de Navegação ---\n");
+            if (temEsquerda) {
+                escrever(saida, "  [E] - Seguir para a esquerda\n");
+            }
+            if (temDireita) {
+                escrever(saida, "  [D] - Seguir para a direita\n");
+            }
+            for (int p = primeiraPorta; numeradas > 0 && p < fimPortas; p++) {
+                if (mansao->rotuloPorta[p] == PORTA_NUMERADA) {
+                    escrever(saida, "  [%d] - Ir para %s\n", p - primeiraPorta + 1,
+                             mansao->nomes[mansao->destinoPorta[p]]);
+                }
+            }
+            if (anterior >= 0) {
+                escrever(saida, "  [V] - Voltar para %s\n", mansao->nomes[anterior]);
+            }
+            if (historico->total > 1) {
+                escrever(saida, "  [U] - Desfazer a última pista coletada\n");
+                escrever(saida, "  (versao <n> mostra o diário depois da n-ésima pista)\n");
+            }
+            escrever(saida, "  [P] - Ver pistas ao alcance\n");
+            escrever(saida, "  [H] - Dica de rota\n");
+            escrever(saida, "  [S] - Finalizar exploração\n");
+            escrever(saida, "  (vários movimentos de uma vez, ex.: EED, goto <sala> ou diario [página])\n");
+            escrever(saida, "\n📊 Pistas coletadas: %d\n", diario_contar(historico->versoes[historico->total - 1]));
+            escrever(saida, "\nSua escolha: ");
+            return;
+        }
+        
+        escolha = proximoMovimento(fila);
+        proxima = -1;
+        
+        if (EH_MOVIMENTO_PORTA(escolha)) {
+            int porta = primeiraPorta + (escolha - MOVIMENTO_PORTA(0));
+            if (porta < fimPortas && mansao->rotuloPorta[porta] == PORTA_NUMERADA) {
+                proxima = mansao->destinoPorta[porta];
+                escrever(saida, "\n➜ Indo para %s...\n", mansao->nomes[proxima]);
+            } else {
+                escrever(saida, "\n❌ Comando inválido!\n");
+                fila->total = 0;
+            }
+        }
+        else if (escolha == 'e' || escolha == 'E' || escolha == 'd' || escolha == 'D') {
+            char rotulo = (escolha == 'e' || escolha == 'E') ? 'E' : 'D';
+            for (int p = primeiraPorta; p < fimPortas; p++) {
+                if (mansao->rotuloPorta[p] == rotulo) {
+                    proxima = mansao->destinoPorta[p];
+                    break;
+                }
+            }
+            if (proxima >= 0) {
+                escrever(saida, "\n➜ Indo para a %s...\n", rotulo == 'E' ? "esquerda" : "direita");
+            } else {
+                escrever(saida, "\n❌ Caminho bloqueado!\n");
+                fila->total = 0;
+            }
+        }
+        else if (escolha == 'v' || escolha == 'V') {
+            if (trilha->total > 1) {
+                trilha->naTrilha[trilha->salas[--trilha->total]] = 0;
+                sessao->salaAtual = trilha->salas[trilha->total - 1];
+                sessao->entrouNaSala = 1;
+                escrever(saida, "\n⬅️  Voltando para %s...\n", mansao->nomes[sessao->salaAtual]);
+            } else {
+                escrever(saida, "\n❌ Você já está na entrada da mansão!\n");
+                fila->total = 0;
+            }
+        }
+        else if (escolha == 'u' || escolha == 'U') {
+            const char *removida = desfazerVersao(sessao);
+            if (removida != NULL) {
+                escrever(saida, "\n↩️  Pista removida do diário: \"%s\"\n", removida);
+                misturarResumo(sessao, RESUMO_DESFEITA
+                                       | (uint64_t)diario_contar(historico->versoes[historico->total - 1]));
+            } else {
+                escrever(saida, "\n❌ Não há pistas para desfazer!\n");
+                fila->total = 0;
+            }
+        }
+        else if (escolha == 'p' || escolha == 'P') {
+            exibirPistasAlcancaveis(sessao);
+        }
+        else if (escolha == 'h' || escolha == 'H') {
+            exibirDica(sessao);
+        }
+        else if (escolha == 's' || escolha == 'S') {
+            escrever(saida, "\n➜ Retornando para análise das evidências...\n");
+            fila->total = 0;
+            iniciarJulgamento(sessao);
+            return;
+        } 
+        else {
+            escrever(saida, "\n❌ Comando inválido!\n");
+            fila->total = 0;
+        }
+        
+        if (proxima < 0) {
+            continue;
+        }
+        
+        // Sala que já está na trilha (a mansão tem um ciclo): a trilha volta
+        // até ela, em vez de repetir o trecho do ciclo. Cada sala retirada
+        // aqui entrou uma vez, então o recuo custa O(1) amortizado.
+        if (trilha->naTrilha[proxima]) {
+            while (trilha->salas[trilha->total - 1] != proxima) {
+                trilha->naTrilha[trilha->salas[--trilha->total]] = 0;
+            }
+        } else {
+            acrescentarNaTrilha(trilha, proxima);
+        }
+        sessao->salaAtual = proxima;
+        sessao->entrouNaSala = 1;
+    }
+}
+
+/*
+ * Função: verificarSuspeitoFinal
+ * Descrição: Conduz a fase de julgamento final e verifica a acusação
+ * Parâmetros:
+ *   - sessao: partida na fase de acusação
+ *   - acusado: nome digitado pelo jogador
+ * Retorno: void
+ */
+void verificarSuspeitoFinal(Sessao *sessao, const char *acusado) {
+    const TabelaHash *hash = sessao->hash;
+    Saida *saida = sessao->saida;
+    int pontuacaoLocal[MAX_SUSPEITOS];
+    int *pontuacao = pontuacaoLocal;
+    
+    escrever(saida, "\n==============================================\n");
+    escrever(saida, "        🔎 ANALISANDO ACUSAÇÃO...\n");
+    escrever(saida, "==============================================\n");
+    
+    // Uma única passada pelas evidências pontua todos os suspeitos
+    // (catálogos carregados podem ter mais suspeitos que o vetor local)
+    if (hash->totalSuspeitos > MAX_SUSPEITOS) {
+        pontuacao = (int*)malloc(sizeof(int) * (size_t)hash->totalSuspeitos);
+        if (pontuacao == NULL) {
+            printf("Erro ao alocar memória para pontuação!\n");
+            exit(1);
+        }
+    }
+    pontuarDiario(sessao, pontuacao);
+    int idAcusado = buscarIdSuspeito(hash, acusado);
+    int pesoEvidencias = idAcusado >= 0 ? pontuacao[idAcusado] : 0;
+    misturarResumo(sessao, (uint64_t)(uint32_t)idAcusado << 32 | (uint32_t)pesoEvidencias);
+    if (pontuacao != pontuacaoLocal) {
+        free(pontuacao);
+    }
+    
+    escrever(saida, "\n📊 Resultado da análise:\n");
+    escrever(saida, "   Peso das evidências contra %s: %d\n\n", acusado, pesoEvidencias);
+    
+    if (pesoEvidencias >= 2) {
+        escrever(saida, "✅ CASO RESOLVIDO!\n\n");
+        escrever(saida, "   Há evidências suficientes (peso %d) para\n", pesoEvidencias);
+        escrever(saida, "   sustentar a acusação contra %s.\n\n", acusado);
+        escrever(saida, "   🎉 Parabéns, detetive! O culpado foi capturado!\n");
+    } else if (pesoEvidencias == 1) {
+        escrever(saida, "⚠️  EVIDÊNCIAS INSUFICIENTES!\n\n");
+        escrever(saida, "   As evidências contra %s somam só peso 1.\n", acusado);
+        escrever(saida, "   É necessário peso 2 ou mais para\n");
+        escrever(saida, "   uma acusação conclusiva.\n\n");
+        escrever(saida, "   O caso permanece em aberto...\n");
+    } else {
+        escrever(saida, "❌ ACUSAÇÃO INCORRETA!\n\n");
+        escrever(saida, "   As evidências não pesam contra %s (peso %d).\n", acusado, pesoEvidencias);
+        escrever(saida, "   Revise as evidências com mais atenção.\n\n");
+        escrever(saida, "   O verdadeiro culpado permanece livre...\n");
+    }
+    
+    encerrarSessao(sessao);
+}
+
+/*
+ * Registro binário das partidas
+ * Com --gravar ARQUIVO, os comandos que chegam a cada sessão (já
+ * traduzidos em movimentos) e a acusação são gravados em um registro
+ * compacto, que --repetir ARQUIVO executa de novo sem entrada nem saída.
+ * Formato: MAGICO_REGISTRO seguido de registros com cabeçalho varint
+ * (tamanho << 1 | tipo) e o conteúdo:
+ *   - REGISTRO_NOME: texto de um acusado. Os nomes recebem ids 0, 1, 2...
+ *     na ordem do arquivo e só são gravados na primeira acusação.
+ *   - REGISTRO_PARTIDA: resumo dos resultados (8 bytes, little-endian) e
+ *     os tokens varint (valor << BITS_TOKEN | tipo). Nos movimentos o
+ *     valor é o número de repetições seguidas; nas portas numeradas, o
+ *     índice da porta na sala; na acusação, o id do nome.
+ * O resumo mistura as salas visitadas, as pistas coletadas e desfeitas,
+ * as pistas do diário final na ordem exibida e o veredito. O DQR4 passou
+ * a incluir a ordem do diário; registros DQR3 não são mais aceitos.
+ * Varints: 7 bits por byte, do menos significativo ao mais; o bit alto
+ * indica que há mais bytes.
+ */
+enum { REGISTRO_PARTIDA, REGISTRO_NOME };
+
+enum {
+    TOKEN_ESQUERDA, TOKEN_DIREITA, TOKEN_VOLTAR, TOKEN_DESFAZER, TOKEN_SAIR,
+    TOKEN_PISTAS_ALCANCE, TOKEN_DICA,
+    TOKEN_INVALIDO,                 // Outro caractere: só gera "Comando inválido"
+    TOKEN_FIM_COMANDO,              // Fim da linha: executa os movimentos
+    TOKEN_ACUSACAO,
+    TOKEN_PORTA                     // Porta numerada
+};
+
+// Movimento enfileirado na repetição de cada token de movimento
+static const char movimentosToken[] = { 'E', 'D', 'V', 'U', 'S', 'P', 'H', '?' };
+
+// Grava valor em destino como varint; retorna os bytes usados (até 10)
+static size_t codificarVarint(unsigned char destino[10], uint64_t valor) {
+    size_t total = 0;
+    while (valor >= 0x80) {
+        destino[total++] = (unsigned char)(valor | 0x80);
+        valor >>= 7;
+    }
+    destino[total++] = (unsigned char)valor;
+    return total;
+}
+
+// Lê um varint de [*cursor, fim); retorna 0 se os dados acabam no meio dele
+static int lerVarint(const unsigned char **cursor, const unsigned char *fim, uint64_t *valor) {
+    uint64_t resultado = 0;
+    for (int deslocamento = 0; *cursor < fim && deslocamento < 64; deslocamento += 7) {
+        unsigned char byte = *(*cursor)++;
+        resultado |= (uint64_t)(byte & 0x7F) << deslocamento;
+        if (!(byte & 0x80)) {
+            *valor = resultado;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void acrescentarVarint(BufferRegistro *buffer, uint64_t valor) {
+    if (buffer->tamanho + 10 > buffer->capacidade) {
+        buffer->capacidade = buffer->capacidade > 0 ? 2 * buffer->capacidade : 64;
+        buffer->dados = (unsigned char*)realloc(buffer->dados, buffer->capacidade);
+        if (buffer->dados == NULL) {
+            printf("Erro ao alocar memória para o registro!\n");
+            exit(1);
+        }
+    }
+    buffer->tamanho += codificarVarint(buffer->dados + buffer->tamanho, valor);
+}
+
+static void gravarCabecalhoRegistro(Gravador *gravador, size_t tamanho, int tipo) {
+    unsigned char bytes[10];
+    fwrite(bytes, 1, codificarVarint(bytes, (uint64_t)tamanho << 1 | (uint64_t)tipo), gravador->arquivo);
+}
+
+static int tokenDoMovimento(int movimento) {
+    if (EH_MOVIMENTO_PORTA(movimento)) {
+        return TOKEN_PORTA;
+    }
+    switch (movimento) {
+        case 'e': case 'E': return TOKEN_ESQUERDA;
+        case 'd': case 'D': return TOKEN_DIREITA;
+        case 'v': case 'V': return TOKEN_VOLTAR;
+        case 'u': case 'U': return TOKEN_DESFAZER;
+        case 's': case 'S': return TOKEN_SAIR;
+        case 'p': case 'P': return TOKEN_PISTAS_ALCANCE;
+        case 'h': case 'H': return TOKEN_DICA;
+        default: return TOKEN_INVALIDO;
+    }
+}
+
+/*
+ * Função: acrescentarNomeRegistro
+ * Descrição: Dá ao nome (que passa a pertencer à lista) o próximo id
+ * Retorno: id do nome
+ */
+int acrescentarNomeRegistro(NomesRegistro *nomes, char *nome) {
+    if (nomes->total == nomes->capacidade) {
+        nomes->capacidade = nomes->capacidade > 0 ? 2 * nomes->capacidade : 16;
+        nomes->textos = (char**)realloc(nomes->textos, sizeof(char*) * (size_t)nomes->capacidade);
+        if (nomes->textos == NULL) {
+            printf("Erro ao alocar memória para os nomes do registro!\n");
+            exit(1);
+        }
+    }
+    nomes->textos[nomes->total] = nome;
+    return nomes->total++;
+}
 
 /*
- * Função: funcaoHash
- * Descrição: Calcula o índice hash para uma string (pista)
+ * Função: abrirGravador
+ * Descrição: Cria o arquivo de registro e grava o cabeçalho
  * Parâmetros:
- *   - chave: string da pista
- * Retorno: índice na tabela hash (0 a TAMANHO_HASH-1)
+ *   - gravador: gravador a preparar
+ *   - caminho: arquivo a criar (sobrescrito se existir)
+ * Retorno: void
  */
-unsigned int funcaoHash(const char *chave) {
-    unsigned int hash = 0;
-    while (*chave) {
-        hash = (hash * 31) + (*chave);
-        chave++;
+void abrirGravador(Gravador *gravador, const char *caminho) {
+    gravador->arquivo = fopen(caminho, "wb");
+    if (gravador->arquivo == NULL) {
+        printf("Erro: não foi possível criar o registro \"%s\": %s\n", caminho, strerror(errno));
+        exit(1);
     }
-    return hash % TAMANHO_HASH;
+    fwrite(MAGICO_REGISTRO, 1, strlen(MAGICO_REGISTRO), gravador->arquivo);
+    nomes_inicializar(&gravador->nomes.indice, BALDES_SUSPEITOS);
+    gravador->nomes.textos = NULL;
+    gravador->nomes.total = 0;
+    gravador->nomes.capacidade = 0;
+    gravador->partidas = 0;
 }
 
 /*
- * Função: inicializarHash
- * Descrição: Inicializa a tabela hash com todos os ponteiros NULL
- * Parâmetros:
- *   - hash: ponteiro para a tabela hash
- * Retorno: void
+ * Função: fecharGravador
+ * Descrição: Fecha o arquivo de registro e solta os nomes
  */
-void inicializarHash(TabelaHash *hash) {
-    for (int i = 0; i < TAMANHO_HASH; i++) {
-        hash->tabela[i] = NULL;
+void fecharGravador(Gravador *gravador) {
+    if (fclose(gravador->arquivo) != 0) {
+        printf("Aviso: o registro de partidas pode estar incompleto!\n");
+    }
+    nomes_liberar(&gravador->nomes.indice);
+    for (int i = 0; i < gravador->nomes.total; i++) {
+        free(gravador->nomes.textos[i]);
     }
+    free(gravador->nomes.textos);
 }
 
 /*
- * Função: inserirNaHash
- * Descrição: Insere uma associação pista-suspeito na tabela hash
+ * Função: gravarComando
+ * Descrição: Grava os movimentos que uma linha deixou na fila (em
+ *            sequências de movimentos iguais, exceto portas numeradas)
+ *            e o fim do comando
  * Parâmetros:
- *   - hash: ponteiro para a tabela hash
- *   - pista: string da pista (chave)
- *   - suspeito: string do nome do suspeito (valor)
+ *   - sessao: partida gravada, com a fila ainda intacta
  * Retorno: void
  */
-void inserirNaHash(TabelaHash *hash, const char *pista, const char *suspeito) {
-    unsigned int indice = funcaoHash(pista);
+void gravarComando(Sessao *sessao) {
+    const FilaMovimentos *fila = &sessao->fila;
     
-    // Cria novo nó
-    HashNode *novoNo = (HashNode*)malloc(sizeof(HashNode));
-    if (novoNo == NULL) {
-        printf("Erro ao alocar memória para hash!\n");
-        exit(1);
+    for (int i = 0; i < fila->total; ) {
+        int movimento = fila->movimentos[(fila->inicio + i) % fila->capacidade];
+        int token = tokenDoMovimento(movimento);
+        if (token == TOKEN_PORTA) {
+            acrescentarVarint(&sessao->registro,
+                              (uint64_t)(movimento - MOVIMENTO_PORTA(0)) << BITS_TOKEN | TOKEN_PORTA);
+            i++;
+            continue;
+        }
+        uint64_t repeticoes = 0;
+        while (i < fila->total &&
+               tokenDoMovimento(fila->movimentos[(fila->inicio + i) % fila->capacidade]) == token) {
+            repeticoes++;
+            i++;
+        }
+        acrescentarVarint(&sessao->registro, repeticoes << BITS_TOKEN | (uint64_t)token);
     }
-    
-    strcpy(novoNo->pista, pista);
-    strcpy(novoNo->suspeito, suspeito);
-    novoNo->proximo = hash->tabela[indice];  // Insere no início da lista
-    hash->tabela[indice] = novoNo;
+    acrescentarVarint(&sessao->registro, TOKEN_FIM_COMANDO);
 }
 
 /*
- * Função: encontrarSuspeito
- * Descrição: Busca o suspeito associado a uma pista na tabela hash
+ * Função: gravarAcusacao
+ * Descrição: Grava a acusação pelo id do nome. Um nome novo ganha id e
+ *            vai para o arquivo antes de qualquer partida que o use.
  * Parâmetros:
- *   - hash: ponteiro para a tabela hash
- *   - pista: string da pista a ser buscada
- * Retorno: ponteiro para string com nome do suspeito (ou NULL se não encontrado)
+ *   - sessao: partida gravada
+ *   - acusado: nome já truncado, como chega a verificarSuspeitoFinal
+ * Retorno: void
  */
-const char* encontrarSuspeito(TabelaHash *hash, const char *pista) {
-    unsigned int indice = funcaoHash(pista);
-    HashNode *atual = hash->tabela[indice];
+void gravarAcusacao(Sessao *sessao, const char *acusado) {
+    Gravador *gravador = sessao->gravador;
+    const NomeNode *nome = nomes_buscar(&gravador->nomes.indice, acusado);
     
-    // Percorre a lista encadeada no índice
-    while (atual != NULL) {
-        if (strcmp(atual->pista, pista) == 0) {
-            return atual->suspeito;
+    if (nome == NULL) {
+        char *copia = strdup(acusado);
+        if (copia == NULL) {
+            printf("Erro ao alocar memória para os nomes do registro!\n");
+            exit(1);
         }
-        atual = atual->proximo;
+        NomeNode *novo = nomes_inserir(&gravador->nomes.indice, copia);
+        novo->id = acrescentarNomeRegistro(&gravador->nomes, copia);
+        gravarCabecalhoRegistro(gravador, strlen(copia), REGISTRO_NOME);
+        fwrite(copia, 1, strlen(copia), gravador->arquivo);
+        nome = novo;
     }
+    acrescentarVarint(&sessao->registro, (uint64_t)nome->id << BITS_TOKEN | TOKEN_ACUSACAO);
+}
+
+/*
+ * Função: gravarPartida
+ * Descrição: Escreve no arquivo o registro da partida, com o resumo dos
+ *            resultados até aqui (partidas sem nenhum comando são omitidas)
+ */
+void gravarPartida(Sessao *sessao) {
+    Gravador *gravador = sessao->gravador;
+    unsigned char resumo[8];
     
-    return NULL;  // Pista não encontrada
+    if (sessao->registro.tamanho > 0) {
+        for (int i = 0; i < 8; i++) {
+            resumo[i] = (unsigned char)(sessao->resumo >> (8 * i));
+        }
+        gravarCabecalhoRegistro(gravador, sizeof(resumo) + sessao->registro.tamanho, REGISTRO_PARTIDA);
+        fwrite(resumo, 1, sizeof(resumo), gravador->arquivo);
+        fwrite(sessao->registro.dados, 1, sessao->registro.tamanho, gravador->arquivo);
+        gravador->partidas++;
+    }
+    free(sessao->registro.dados);
+    sessao->registro.dados = NULL;
+    sessao->registro.tamanho = 0;
+    sessao->registro.capacidade = 0;
 }
 
 /*
- * Função: criarSala
- * Descrição: Cria dinamicamente uma nova sala com nome
+ * Função: iniciarSessao
+ * Descrição: Começa uma partida na entrada da mansão e avança até o
+ *            primeiro pedido de comando
  * Parâmetros:
- *   - nome: string com o nome do cômodo
- * Retorno: ponteiro para a sala criada
+ *   - sessao: partida a iniciar
+ *   - hash: tabela hash compartilhada (somente leitura)
+ *   - mansao: grafo da mansão compartilhado (somente leitura)
+ *   - saida: destino do texto da partida
+ *   - gravador: registro onde gravar os comandos (NULL para não gravar)
+ * Retorno: void
  */
-Sala* criarSala(const char *nome) {
-    Sala *novaSala = (Sala*)malloc(sizeof(Sala));
+void iniciarSessao(Sessao *sessao, const TabelaHash *hash, const GrafoMansao *mansao,
+                   Saida *saida, Gravador *gravador) {
+    sessao->hash = hash;
+    sessao->mansao = mansao;
+    sessao->saida = saida;
+    sessao->gravador = gravador;
+    sessao->registro.dados = NULL;
+    sessao->registro.tamanho = 0;
+    sessao->registro.capacidade = 0;
+    sessao->resumo = 0xcbf29ce484222325ULL;
+    sessao->fase = FASE_EXPLORANDO;
+    sessao->salaAtual = mansao->entrada;
+    sessao->entrouNaSala = 1;
+    sessao->fila.movimentos = sessao->fila.movimentosLocal;
+    sessao->fila.inicio = 0;
+    sessao->fila.total = 0;
+    sessao->fila.capacidade = MAX_MOVIMENTOS;
+    sessao->trilha.salas = sessao->trilha.salasLocal;
+    sessao->trilha.capacidade = MAX_TRILHA;
+    sessao->trilha.total = 0;
+    sessao->historico.versoes = sessao->historico.versoesLocal;
+    sessao->historico.pistas = sessao->historico.pistasLocal;
+    sessao->historico.idsPista = sessao->historico.idsPistaLocal;
+    sessao->historico.salas = sessao->historico.salasLocal;
+    sessao->historico.capacidade = MAX_VERSOES;
+    sessao->historico.memoria = NULL;
+    sessao->historico.versoes[0] = NULL;
+    sessao->historico.pistas[0] = NULL;
+    sessao->historico.idsPista[0] = -1;
+    sessao->historico.salas[0] = -1;
+    sessao->historico.total = 1;
+    sessao->arvorePistas = NULL;
     
-    if (novaSala == NULL) {
-        printf("Erro ao alocar memória para sala!\n");
+    // Mansões grandes: estado de visita e marcas da trilha alocados, como
+    // a pontuação
+    size_t salas = mansao->totalSalas > MAX_SALAS ? (size_t)mansao->totalSalas : MAX_SALAS;
+    sessao->estadoSalas = salas > MAX_SALAS ? (unsigned char*)malloc(2 * salas) : sessao->estadoSalasLocal;
+    if (sessao->estadoSalas == NULL) {
+        printf("Erro ao alocar memória para a sessão!\n");
         exit(1);
     }
+    memset(sessao->estadoSalas, SALA_NAO_VISITADA, 2 * salas);
+    sessao->trilha.naTrilha = sessao->estadoSalas + salas;
+    acrescentarNaTrilha(&sessao->trilha, mansao->entrada);
+    memset(sessao->pistasColetadas, 0, (size_t)mansao->quadro.palavras * sizeof(uint64_t));
+    sessao->dica.memoria = NULL;
+    sessao->percurso.memoria = NULL;
     
-    strcpy(novaSala->nome, nome);
-    novaSala->esquerda = NULL;
-    novaSala->direita = NULL;
+    escrever(saida, "==============================================\n");
+    escrever(saida, "     DETECTIVE QUEST - ENIGMA STUDIOS\n");
+    escrever(saida, "          Capítulo Final\n");
+    escrever(saida, "==============================================\n");
+    escrever(saida, "\n🕵️  Uma mansão misteriosa...\n");
+    escrever(saida, "   Pistas escondidas...\n");
+    escrever(saida, "   E um culpado a ser desmascarado!\n\n");
+    escrever(saida, "   Sua missão: explorar, coletar evidências\n");
+    escrever(saida, "   e fazer justiça!\n");
     
-    return novaSala;
+    explorarSalas(sessao);
 }
 
 /*
- * Função: obterPistaDaSala
- * Descrição: Retorna a pista associada a uma sala específica (lógica codificada)
+ * Função: receberLinha
+ * Descrição: Entrega uma linha de entrada à partida e avança até o
+ *            próximo pedido de entrada (ou até o fim da partida)
  * Parâmetros:
- *   - nomeSala: string com o nome da sala
- * Retorno: ponteiro para string com a pista (ou string vazia se não houver)
+ *   - sessao: partida em andamento
+ *   - linha: linha recebida, sem o \n (NULL no fim da entrada)
+ * Retorno: void
  */
-const char* obterPistaDaSala(const char *nomeSala) {
-    // Mapeamento estático: sala -> pista
-    if (strcmp(nomeSala, "Hall de Entrada") == 0)
-        return "Pegadas molhadas no tapete";
-    else if (strcmp(nomeSala, "Cozinha") == 0)
-        return "Faca desaparecida do bloco";
-    else if (strcmp(nomeSala, "Biblioteca") == 0)
-        return "Livro aberto sobre venenos";
-    else if (strcmp(nomeSala, "Despensa") == 0)
-        return "Frasco vazio de arsenico";
-    else if (strcmp(nomeSala, "Sala Secreta") == 0)
-        return "Documento queimado parcialmente";
-    else if (strcmp(nomeSala, "Sala de Leitura") == 0)
-        return "Carta ameacadora escondida";
-    else if (strcmp(nomeSala, "Cofre") == 0)
-        return "Testamento adulterado";
-    else if (strcmp(nomeSala, "Estufa") == 0)
-        return "Planta venenosa cultivada";
-    else
-        return "";  // Sala sem pista
+void receberLinha(Sessao *sessao, const char *linha) {
+    if (sessao->fase == FASE_EXPLORANDO) {
+        // No fim da entrada a exploração termina como se fosse S
+        if (linha == NULL) {
+            enfileirarMovimento(&sessao->fila, 'S');
+        } else {
+            interpretarComando(sessao, linha);
+        }
+        if (sessao->fila.total > 0) {
+            if (sessao->gravador != NULL) {
+                gravarComando(sessao);
+            }
+            explorarSalas(sessao);
+        }
+    } else if (sessao->fase == FASE_ACUSANDO) {
+        // Nomes têm no máximo TAMANHO_NOME - 1 caracteres
+        char acusado[TAMANHO_NOME];
+        snprintf(acusado, sizeof(acusado), "%s", linha != NULL ? linha : "");
+        if (sessao->gravador != NULL) {
+            gravarAcusacao(sessao, acusado);
+        }
+        verificarSuspeitoFinal(sessao, acusado);
+    }
 }
 
 /*
- * Função: inserirPista (ou adicionarPista)
- * Descrição: Insere uma nova pista na árvore BST de forma ordenada
+ * Função: liberarSessao
+ * Descrição: Grava a partida (se gravada) e solta os seus diários, em
+ *            qualquer fase
+ */
+void liberarSessao(Sessao *sessao) {
+    if (sessao->gravador != NULL) {
+        gravarPartida(sessao);
+    }
+    for (int i = 0; i < sessao->historico.total; i++) {
+        liberarArvorePistas(sessao->historico.versoes[i]);
+    }
+    sessao->historico.total = 0;
+    free(sessao->historico.memoria);
+    sessao->historico.memoria = NULL;
+    liberarArvorePistas(sessao->arvorePistas);
+    sessao->arvorePistas = NULL;
+    liberarPlano(&sessao->dica);
+    liberarPercurso(&sessao->percurso);
+    if (sessao->fila.movimentos != sessao->fila.movimentosLocal) {
+        free(sessao->fila.movimentos);
+        sessao->fila.movimentos = sessao->fila.movimentosLocal;
+    }
+    if (sessao->trilha.salas != sessao->trilha.salasLocal) {
+        free(sessao->trilha.salas);
+        sessao->trilha.salas = sessao->trilha.salasLocal;
+    }
+    if (sessao->estadoSalas != sessao->estadoSalasLocal) {
+        free(sessao->estadoSalas);
+        sessao->estadoSalas = sessao->estadoSalasLocal;
+    }
+}
+
+/*
+ * Função: liberarHash
+ * Descrição: Libera memória de uma tabela hash montada com inicializarHash
+ *            e inserirNaHash ou com carregarCatalogo
+ */
+void liberarHash(TabelaHash *hash) {
+    PERFIL_MEDIR(PERFIL_LIBERAR_HASH);
+    int liberados;
+    
+    if (hash->arquivo.dados != NULL) {
+        // Catálogo carregado: nós em um só bloco, textos no arquivo mapeado
+        free(hash->arquivo.nos);
+        free(hash->indice.baldes);
+        munmap(hash->arquivo.dados, hash->arquivo.tamanho);
+        liberados = 1;
+    } else {
+        liberados = indice_liberar(&hash->indice);
+    }
+    free(hash->filtro);
+    free(hash->memoria);
+    PERFIL_LIBERACAO(PERFIL_LIBERAR_HASH, liberados);
+}
+
+/*
+ * Função: repetirPartida
+ * Descrição: Executa os tokens de um registro de partida em uma sessão
+ *            sem saída, exatamente como as linhas originais
  * Parâmetros:
- *   - raiz: ponteiro para a raiz da árvore de pistas
- *   - pista: string com a pista a ser inserida
- * Retorno: ponteiro para a raiz da árvore
+ *   - sessao: partida recém-iniciada
+ *   - nomes: nomes de acusados lidos até aqui
+ *   - cursor, fim: tokens da partida
+ * Retorno: comandos executados, ou -1 se o registro está corrompido
  */
-PistaNode* inserirPista(PistaNode *raiz, const char *pista) {
-    if (raiz == NULL) {
-        PistaNode *novaPista = (PistaNode*)malloc(sizeof(PistaNode));
-        
-        if (novaPista == NULL) {
-            printf("Erro ao alocar memória para pista!\n");
-            exit(1);
+long repetirPartida(Sessao *sessao, const NomesRegistro *nomes,
+                    const unsigned char *cursor, const unsigned char *fim) {
+    long comandos = 0;
+    uint64_t token;
+    // Uma linha deixa na fila no máximo MAX_MOVIMENTOS movimentos digitados
+    // ou a rota de um goto, que passa por menos portas do que há salas
+    long long limite = MAX_MOVIMENTOS + (long long)sessao->mansao->totalSalas;
+    
+    while (cursor < fim) {
+        if (!lerVarint(&cursor, fim, &token)) {
+            return -1;
         }
+        int tipo = (int)(token & ((1u << BITS_TOKEN) - 1));
+        uint64_t valor = token >> BITS_TOKEN;
         
-        strcpy(novaPista->pista, pista);
-        novaPista->esquerda = NULL;
-        novaPista->direita = NULL;
-        
-        return novaPista;
+        if (tipo == TOKEN_FIM_COMANDO) {
+            if (sessao->fase != FASE_EXPLORANDO) {
+                return -1;
+            }
+            if (sessao->fila.total > 0) {
+                explorarSalas(sessao);
+            }
+            comandos++;
+        } else if (tipo == TOKEN_ACUSACAO) {
+            if (sessao->fase != FASE_ACUSANDO || valor >= (uint64_t)nomes->total) {
+                return -1;
+            }
+            verificarSuspeitoFinal(sessao, nomes->textos[valor]);
+            comandos++;
+        } else if (tipo == TOKEN_PORTA) {
+            if (valor > INT_MAX / 2 || sessao->fila.total >= limite) {
+                return -1;
+            }
+            enfileirarMovimento(&sessao->fila, MOVIMENTO_PORTA((int)valor));
+        } else if (tipo <= TOKEN_INVALIDO) {
+            if (valor > (uint64_t)(limite - sessao->fila.total)) {
+                return -1;
+            }
+            for (uint64_t i = 0; i < valor; i++) {
+                enfileirarMovimento(&sessao->fila, movimentosToken[tipo]);
+            }
+        } else {
+            return -1;
+        }
+    }
+    return comandos;
+}
+
+/*
+ * Função: repetirRegistro
+ * Descrição: Repete as partidas de um arquivo de registro na velocidade
+ *            máxima, sem E/S, e confere se os resultados são idênticos
+ *            aos gravados. Serve também como carga de desempenho.
+ * Parâmetros:
+ *   - caminho: arquivo gravado com --gravar
+ *   - hash: tabela hash da gravação (o mesmo catálogo)
+ *   - mansao: mansão da gravação
+ *   - vezes: quantas vezes o arquivo inteiro é repetido
+ * Retorno: 1 se todas as partidas tiveram resultados idênticos
+ */
+int repetirRegistro(const char *caminho, const TabelaHash *hash, const GrafoMansao *mansao, int vezes) {
+    FILE *arquivo = fopen(caminho, "rb");
+    if (arquivo == NULL) {
+        printf("Erro: não foi possível abrir o registro \"%s\": %s\n", caminho, strerror(errno));
+        exit(1);
+    }
+    fseek(arquivo, 0, SEEK_END);
+    long tamanho = ftell(arquivo);
+    rewind(arquivo);
+    unsigned char *dados = (unsigned char*)malloc(tamanho > 0 ? (size_t)tamanho : 1);
+    if (dados == NULL) {
+        printf("Erro ao alocar memória para o registro!\n");
+        exit(1);
+    }
+    size_t lidos = tamanho > 0 ? fread(dados, 1, (size_t)tamanho, arquivo) : 0;
+    fclose(arquivo);
+    
+    const size_t tamanhoMagico = strlen(MAGICO_REGISTRO);
+    if (tamanho < 0 || lidos != (size_t)tamanho || lidos < tamanhoMagico ||
+        memcmp(dados, MAGICO_REGISTRO, tamanhoMagico) != 0) {
+        printf("Erro: \"%s\" não é um registro de partidas!\n", caminho);
+        exit(1);
     }
     
-    int comparacao = strcmp(pista, raiz->pista);
+    const unsigned char *fim = dados + lidos;
+    NomesRegistro nomes = { .textos = NULL, .total = 0, .capacidade = 0 };
+    Saida descartada = { .descartar = 1 };
+    unsigned long partidas = 0, divergentes = 0;
+    unsigned long long comandos = 0;
+    struct timespec inicio, termino;
     
-    if (comparacao < 0) {
-        raiz->esquerda = inserirPista(raiz->esquerda, pista);
-    } else if (comparacao > 0) {
-        raiz->direita = inserirPista(raiz->direita, pista);
+    clock_gettime(CLOCK_MONOTONIC, &inicio);
+    for (int vez = 0; vez < vezes; vez++) {
+        const unsigned char *cursor = dados + tamanhoMagico;
+        nomes.total = 0;
+        
+        while (cursor < fim) {
+            uint64_t cabecalho;
+            if (!lerVarint(&cursor, fim, &cabecalho) || (cabecalho >> 1) > (uint64_t)(fim - cursor)) {
+                printf("Erro: registro \"%s\" corrompido!\n", caminho);
+                exit(1);
+            }
+            const unsigned char *conteudo = cursor;
+            cursor += cabecalho >> 1;
+            
+            if ((cabecalho & 1) == REGISTRO_NOME) {
+                // No arquivo o nome não tem \0: guarda uma cópia terminada
+                char *nome = (char*)malloc((size_t)(cursor - conteudo) + 1);
+                if (nome == NULL) {
+                    printf("Erro ao alocar memória para os nomes do registro!\n");
+                    exit(1);
+                }
+                memcpy(nome, conteudo, (size_t)(cursor - conteudo));
+                nome[cursor - conteudo] = '\0';
+                acrescentarNomeRegistro(&nomes, nome);
+                continue;
+            }
+            
+            if (cursor - conteudo < 8) {
+                printf("Erro: registro \"%s\" corrompido!\n", caminho);
+                exit(1);
+            }
+            uint64_t resumoGravado = 0;
+            for (int i = 0; i < 8; i++) {
+                resumoGravado |= (uint64_t)conteudo[i] << (8 * i);
+            }
+            
+            Sessao sessao;
+            iniciarSessao(&sessao, hash, mansao, &descartada, NULL);
+            long executados = repetirPartida(&sessao, &nomes, conteudo + 8, cursor);
+            liberarSessao(&sessao);
+            if (executados < 0) {
+                printf("Erro: registro \"%s\" corrompido (partida %lu)!\n", caminho, partidas + 1);
+                exit(1);
+            }
+            if (sessao.resumo != resumoGravado) {
+                divergentes++;
+            }
+            comandos += (unsigned long long)executados;
+            partidas++;
+        }
+        
+        for (int i = 0; i < nomes.total; i++) {
+            free(nomes.textos[i]);
+        }
     }
+    clock_gettime(CLOCK_MONOTONIC, &termino);
+    free(nomes.textos);
+    free(dados);
     
-    return raiz;
+    double segundos = (double)(termino.tv_sec - inicio.tv_sec) + (termino.tv_nsec - inicio.tv_nsec) / 1e9;
+    printf("🔁 Registro repetido: %lu partidas, %llu comandos em %.3f ms", partidas, comandos, segundos * 1e3);
+    if (segundos > 0) {
+        printf(" (%.0f partidas/s)", partidas / segundos);
+    }
+    printf("\n");
+    if (divergentes > 0) {
+        printf("❌ %lu partidas com resultado diferente do gravado!\n", divergentes);
+        return 0;
+    }
+    printf("✅ Resultados idênticos aos gravados.\n");
+    return 1;
 }
 
 /*
- * Função: contarPistasPorSuspeito
- * Descrição: Conta quantas pistas apontam para um suspeito específico
- * Parâmetros:
- *   - raiz: ponteiro para a raiz da árvore de pistas
- *   - hash: ponteiro para a tabela hash
- *   - suspeitoAlvo: nome do suspeito a ser contado
- * Retorno: número de pistas que apontam para o suspeito
+ * Modo servidor
+ * Um único processo atende várias partidas por um socket Unix. O laço
+ * de eventos (epoll) lê o que chegou em cada conexão, entrega as linhas
+ * completas à sessão e escreve a resposta sem bloquear. Enquanto há
+ * resposta pendente, a conexão só espera poder escrever (e não lê mais
+ * comandos), o que limita a memória de um cliente que não lê.
+ * Mansão e tabela hash são as mesmas para todas as sessões.
+ *
+ * A abertura da partida (até o primeiro pedido de comando) é a mesma em
+ * todas as conexões: é montada uma vez e copiada para cada cliente. A
+ * sessão só é criada quando chega o primeiro comando, de modo que uma
+ * conexão ociosa guarda apenas o descritor, o estado e a linha em
+ * leitura. Sessões encerradas voltam para um estoque do servidor e são
+ * reusadas pelas próximas partidas.
  */
-int contarPistasPorSuspeito(PistaNode *raiz, TabelaHash *hash, const char *suspeitoAlvo) {
-    if (raiz == NULL) {
-        return 0;
+
+// Uma conexão de jogador
+typedef struct Conexao {
+    int descritor;
+    uint32_t eventos;               // Eventos registrados no epoll
+    int fimEntrada;                 // 1 quando o cliente fechou a escrita
+    int descartando;                // 1 ao pular o resto de uma linha longa
+    size_t usados;                  // Bytes em entrada
+    size_t enviados;                // Bytes de saida.dados já escritos
+    Saida saida;
+    Sessao *sessao;                 // NULL até o primeiro comando
+    struct Conexao *anterior;       // Lista das conexões abertas
+    struct Conexao *proxima;
+    char entrada[TAMANHO_LINHA];
+} Conexao;
+
+typedef struct {
+    int epoll;
+    int escuta;
+    Conexao *conexoes;
+    unsigned long abertas;
+    unsigned long atendidas;
+    const TabelaHash *hash;
+    const GrafoMansao *mansao;
+    Gravador *gravador;             // Registro das partidas (NULL se não gravadas)
+    char *abertura;                 // Texto inicial de toda partida
+    Sessao *livres[MAX_SESSOES_LIVRES]; // Sessões encerradas, prontas para reuso
+    int totalLivres;
+} Servidor;
+
+static volatile sig_atomic_t servidorAtivo = 1;
+
+static void pararServidor(int sinal) {
+    (void)sinal;
+    servidorAtivo = 0;
+}
+
+/*
+ * Função: fecharConexao
+ * Descrição: Fecha o socket, solta a sessão e tira a conexão da lista
+ */
+void fecharConexao(Servidor *servidor, Conexao *conexao) {
+    close(conexao->descritor);  // Também a remove do epoll
+    if (conexao->sessao != NULL) {
+        liberarSessao(conexao->sessao);
+        if (servidor->totalLivres < MAX_SESSOES_LIVRES) {
+            servidor->livres[servidor->totalLivres++] = conexao->sessao;
+        } else {
+            free(conexao->sessao);
+        }
     }
+    free(conexao->saida.dados);
     
-    int contador = 0;
-    const char *suspeito = encontrarSuspeito(hash, raiz->pista);
-    
-    if (suspeito != NULL && strcmp(suspeito, suspeitoAlvo) == 0) {
-        contador = 1;
+    if (conexao->anterior != NULL) {
+        conexao->anterior->proxima = conexao->proxima;
+    } else {
+        servidor->conexoes = conexao->proxima;
     }
+    if (conexao->proxima != NULL) {
+        conexao->proxima->anterior = conexao->anterior;
+    }
+    servidor->abertas--;
+    free(conexao);
+}
+
+/*
+ * Função: enviarSaida
+ * Descrição: Escreve no socket o que houver de resposta pendente, até o
+ *            socket encher. Esvaziada, a saída solta o buffer (conexões
+ *            ociosas não guardam memória de saída).
+ * Retorno: 1 se a conexão continua válida, 0 em erro de escrita
+ */
+int enviarSaida(Conexao *conexao) {
+    Saida *saida = &conexao->saida;
     
-    // Recursivamente conta nas subárvores
-    contador += contarPistasPorSuspeito(raiz->esquerda, hash, suspeitoAlvo);
-    contador += contarPistasPorSuspeito(raiz->direita, hash, suspeitoAlvo);
+    while (conexao->enviados < saida->tamanho) {
+        ssize_t escritos = send(conexao->descritor, saida->dados + conexao->enviados,
+                                saida->tamanho - conexao->enviados, MSG_NOSIGNAL);
+        if (escritos < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        conexao->enviados += (size_t)escritos;
+    }
     
-    return contador;
+    free(saida->dados);
+    saida->dados = NULL;
+    saida->tamanho = 0;
+    saida->capacidade = 0;
+    conexao->enviados = 0;
+    return 1;
 }
 
 /*
- * Função: exibirPistasComSuspeitos
- * Descrição: Exibe todas as pistas coletadas com seus respectivos suspeitos
+ * Função: sessaoDaConexao
+ * Descrição: Devolve a sessão da conexão, criando-a no primeiro comando:
+ *            reusa uma sessão encerrada do servidor (ou aloca uma) e a
+ *            inicia sem texto, pois a abertura já foi enviada.
  * Parâmetros:
- *   - raiz: ponteiro para a raiz da árvore de pistas
- *   - hash: ponteiro para a tabela hash
- * Retorno: void
+ *   - servidor: servidor com a mansão, a tabela e as sessões livres
+ *   - conexao: conexão que recebeu um comando
+ * Retorno: a sessão da conexão
  */
-void exibirPistasComSuspeitos(PistaNode *raiz, TabelaHash *hash) {
-    if (raiz == NULL) {
-        return;
+Sessao* sessaoDaConexao(Servidor *servidor, Conexao *conexao) {
+    if (conexao->sessao == NULL) {
+        Sessao *sessao = servidor->totalLivres > 0 ? servidor->livres[--servidor->totalLivres]
+                                                   : (Sessao*)malloc(sizeof(Sessao));
+        if (sessao == NULL) {
+            printf("Erro ao alocar memória para a sessão!\n");
+            exit(1);
+        }
+        conexao->saida.descartar = 1;
+        iniciarSessao(sessao, servidor->hash, servidor->mansao, &conexao->saida, servidor->gravador);
+        conexao->saida.descartar = 0;
+        conexao->sessao = sessao;
     }
+    return conexao->sessao;
+}
+
+/*
+ * Função: processarLinha
+ * Descrição: Entrega à sessão a primeira linha completa da entrada.
+ *            Linhas maiores que o buffer são truncadas, como em lerLinha.
+ * Retorno: 1 se consumiu bytes da entrada, 0 se falta o resto da linha
+ */
+int processarLinha(Servidor *servidor, Conexao *conexao) {
+    char *quebra = (char*)memchr(conexao->entrada, '\n', conexao->usados);
+    size_t consumidos;
     
-    exibirPistasComSuspeitos(raiz->esquerda, hash);
-    
-    const char *suspeito = encontrarSuspeito(hash, raiz->pista);
-    printf("  📋 \"%s\"\n", raiz->pista);
-    if (suspeito != NULL) {
-        printf("     ➜ Aponta para: %s\n\n", suspeito);
+    if (quebra != NULL) {
+        consumidos = (size_t)(quebra - conexao->entrada) + 1;
+        *quebra = '\0';
+        if (quebra > conexao->entrada && quebra[-1] == '\r') {
+            quebra[-1] = '\0';
+        }
+        if (!conexao->descartando) {
+            receberLinha(sessaoDaConexao(servidor, conexao), conexao->entrada);
+        }
+        conexao->descartando = 0;
+    } else if (conexao->usados == sizeof(conexao->entrada) - 1) {
+        // Buffer cheio sem \n: usa o começo e descarta o resto da linha
+        consumidos = conexao->usados;
+        if (!conexao->descartando) {
+            conexao->entrada[conexao->usados] = '\0';
+            receberLinha(sessaoDaConexao(servidor, conexao), conexao->entrada);
+            conexao->descartando = 1;
+        }
+    } else if (conexao->fimEntrada && conexao->usados > 0) {
+        // Última linha sem \n
+        consumidos = conexao->usados;
+        conexao->entrada[conexao->usados] = '\0';
+        if (!conexao->descartando) {
+            receberLinha(sessaoDaConexao(servidor, conexao), conexao->entrada);
+        }
+        conexao->descartando = 0;
+    } else {
+        return 0;
     }
     
-    exibirPistasComSuspeitos(raiz->direita, hash);
+    memmove(conexao->entrada, conexao->entrada + consumidos, conexao->usados - consumidos);
+    conexao->usados -= consumidos;
+    return 1;
 }
 
 /*
- * Função: explorarSalas
- * Descrição: Controla a navegação pela mansão e o sistema de coleta de pistas
- * Parâmetros:
- *   - salaAtual: ponteiro para a sala atual
- *   - arvorePistas: ponteiro para ponteiro da árvore de pistas
- * Retorno: void
+ * Função: atualizarConexao
+ * Descrição: Avança uma conexão o quanto der sem bloquear: envia a
+ *            resposta pendente, processa as linhas já recebidas e lê
+ *            mais. Depois registra no epoll o evento que falta esperar.
  */
-void explorarSalas(Sala *salaAtual, PistaNode **arvorePistas) {
-    char escolha;
-    int pistasTotais = 0;
-    
-    while (salaAtual != NULL) {
-        printf("\n================================================\n");
-        printf("📍 Localização: %s\n", salaAtual->nome);
-        printf("================================================\n");
-        
-        // Verifica se há pista nesta sala
-        const char *pista = obterPistaDaSala(salaAtual->nome);
-        
-        if (strlen(pista) > 0) {
-            printf("\n🔍 PISTA ENCONTRADA!\n");
-            printf("   \"%s\"\n", pista);
-            
-            *arvorePistas = inserirPista(*arvorePistas, pista);
-            pistasTotais++;
-            
-            printf("\n   ✓ Pista registrada no diário\n");
-        } else {
-            printf("\n   Nenhuma pista encontrada aqui.\n");
+void atualizarConexao(Servidor *servidor, Conexao *conexao) {
+    for (;;) {
+        if (!enviarSaida(conexao)) {
+            fecharConexao(servidor, conexao);
+            return;
         }
-        
-        if (salaAtual->esquerda == NULL && salaAtual->direita == NULL) {
-            printf("\n⚠️  Beco sem saída! Use [S] para revisar as pistas.\n");
+        if (conexao->saida.tamanho > 0) {
+            break;  // Socket cheio: espera poder escrever
         }
-        
-        printf("\n--- Opções de Navegação ---\n");
-        if (salaAtual->esquerda != NULL) {
-            printf("  [E] - Seguir para a esquerda\n");
+        if (conexao->sessao != NULL && conexao->sessao->fase == FASE_ENCERRADA) {
+            servidor->atendidas++;
+            fecharConexao(servidor, conexao);
+            return;
         }
-        if (salaAtual->direita != NULL) {
-            printf("  [D] - Seguir para a direita\n");
+        if (processarLinha(servidor, conexao)) {
+            continue;
+        }
+        if (conexao->fimEntrada) {
+            receberLinha(sessaoDaConexao(servidor, conexao), NULL);
+            continue;
         }
-        printf("  [S] - Finalizar exploração\n");
-        printf("\n📊 Pistas coletadas: %d\n", pistasTotais);
-        printf("\nSua escolha: ");
-        
-        scanf(" %c", &escolha);
         
-        if (escolha == 'e' || escolha == 'E') {
-            if (salaAtual->esquerda != NULL) {
-                printf("\n➜ Indo para a esquerda...\n");
-                salaAtual = salaAtual->esquerda;
-            } else {
-                printf("\n❌ Caminho bloqueado!\n");
+        // Deixa espaço para o \0 de uma última linha sem \n
+        ssize_t lidos = read(conexao->descritor, conexao->entrada + conexao->usados,
+                             sizeof(conexao->entrada) - 1 - conexao->usados);
+        if (lidos > 0) {
+            conexao->usados += (size_t)lidos;
+        } else if (lidos == 0) {
+            conexao->fimEntrada = 1;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else if (errno != EINTR) {
+            fecharConexao(servidor, conexao);
+            return;
+        }
+    }
+    
+    uint32_t eventos = conexao->saida.tamanho > 0 ? EPOLLOUT : EPOLLIN;
+    if (eventos != conexao->eventos) {
+        struct epoll_event evento = { .events = eventos, .data.ptr = conexao };
+        epoll_ctl(servidor->epoll, EPOLL_CTL_MOD, conexao->descritor, &evento);
+        conexao->eventos = eventos;
+    }
+}
+
+/*
+ * Função: aceitarConexoes
+ * Descrição: Aceita todas as conexões pendentes e envia a cada uma a
+ *            abertura da partida
+ */
+void aceitarConexoes(Servidor *servidor) {
+    for (;;) {
+        int descritor = accept4(servidor->escuta, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (descritor < 0) {
+            if (errno == EINTR) {
+                continue;
             }
-        } 
-        else if (escolha == 'd' || escolha == 'D') {
-            if (salaAtual->direita != NULL) {
-                printf("\n➜ Indo para a direita...\n");
-                salaAtual = salaAtual->direita;
-            } else {
-                printf("\n❌ Caminho bloqueado!\n");
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                printf("Aviso: accept falhou: %s\n", strerror(errno));
             }
-        } 
-        else if (escolha == 's' || escolha == 'S') {
-            printf("\n➜ Retornando para análise das evidências...\n");
-            break;
-        } 
-        else {
-            printf("\n❌ Comando inválido!\n");
+            return;
+        }
+        
+        Conexao *conexao = (Conexao*)calloc(1, sizeof(Conexao));
+        if (conexao == NULL) {
+            printf("Erro ao alocar memória para conexão!\n");
+            exit(1);
         }
+        conexao->descritor = descritor;
+        conexao->eventos = EPOLLIN;
+        conexao->proxima = servidor->conexoes;
+        if (servidor->conexoes != NULL) {
+            servidor->conexoes->anterior = conexao;
+        }
+        servidor->conexoes = conexao;
+        servidor->abertas++;
+        
+        struct epoll_event evento = { .events = EPOLLIN, .data.ptr = conexao };
+        if (epoll_ctl(servidor->epoll, EPOLL_CTL_ADD, descritor, &evento) != 0) {
+            fecharConexao(servidor, conexao);
+            continue;
+        }
+        
+        escrever(&conexao->saida, "%s", servidor->abertura);
+        atualizarConexao(servidor, conexao);
     }
 }
 
 /*
- * Função: verificarSuspeitoFinal
- * Descrição: Conduz a fase de julgamento final e verifica a acusação
+ * Função: executarServidor
+ * Descrição: Atende partidas no socket Unix indicado até receber SIGINT
+ *            ou SIGTERM
  * Parâmetros:
- *   - arvorePistas: ponteiro para a árvore de pistas
- *   - hash: ponteiro para a tabela hash
+ *   - caminho: caminho do socket (recriado se já existir)
+ *   - hash: tabela hash compartilhada por todas as sessões
+ *   - mansao: grafo da mansão compartilhado por todas as sessões
+ *   - gravador: registro das partidas (NULL para não gravar)
  * Retorno: void
  */
-void verificarSuspeitoFinal(PistaNode *arvorePistas, TabelaHash *hash) {
-    char acusado[50];
-    
-    printf("\n==============================================\n");
-    printf("        ⚖️  FASE DE JULGAMENTO  ⚖️\n");
-    printf("==============================================\n");
+void executarServidor(const char *caminho, const TabelaHash *hash, const GrafoMansao *mansao,
+                      Gravador *gravador) {
+    Servidor servidor = { .conexoes = NULL, .abertas = 0, .atendidas = 0,
+                          .hash = hash, .mansao = mansao, .gravador = gravador, .totalLivres = 0 };
+    struct sockaddr_un endereco = { .sun_family = AF_UNIX };
     
-    if (arvorePistas == NULL) {
-        printf("\n❌ Você não coletou pistas suficientes!\n");
-        printf("   O caso permanece sem solução.\n");
-        return;
+    if (strlen(caminho) >= sizeof(endereco.sun_path)) {
+        printf("Erro: caminho do socket muito longo!\n");
+        exit(1);
     }
+    strcpy(endereco.sun_path, caminho);
     
-    printf("\n📂 Pistas coletadas e suspeitos relacionados:\n\n");
-    exibirPistasComSuspeitos(arvorePistas, hash);
+    servidor.escuta = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(caminho);
+    if (servidor.escuta < 0 ||
+        bind(servidor.escuta, (struct sockaddr*)&endereco, sizeof(endereco)) != 0 ||
+        listen(servidor.escuta, SOMAXCONN) != 0) {
+        printf("Erro: não foi possível escutar em \"%s\": %s\n", caminho, strerror(errno));
+        exit(1);
+    }
     
-    printf("==============================================\n");
-    printf("\nCom base nas evidências, quem você acusa?\n");
-    printf("Digite o nome completo do suspeito: ");
+    servidor.epoll = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event evento = { .events = EPOLLIN, .data.ptr = NULL };
+    if (servidor.epoll < 0 || epoll_ctl(servidor.epoll, EPOLL_CTL_ADD, servidor.escuta, &evento) != 0) {
+        printf("Erro: não foi possível criar o epoll: %s\n", strerror(errno));
+        exit(1);
+    }
     
-    // Limpa o buffer antes de ler string com espaços
-    getchar();
-    fgets(acusado, sizeof(acusado), stdin);
-    // Remove o \n do final
-    acusado[strcspn(acusado, "\n")] = 0;
+    // Sinais só interrompem o epoll_wait (sem SA_RESTART)
+    struct sigaction acao = { .sa_handler = pararServidor };
+    sigemptyset(&acao.sa_mask);
+    sigaction(SIGINT, &acao, NULL);
+    sigaction(SIGTERM, &acao, NULL);
     
-    printf("\n==============================================\n");
-    printf("        🔎 ANALISANDO ACUSAÇÃO...\n");
-    printf("==============================================\n");
+    // Abertura comum a todas as partidas, de uma sessão que não é gravada
+    Saida abertura = { .arquivo = NULL, .dados = NULL, .tamanho = 0, .capacidade = 0, .descartar = 0 };
+    Sessao *modelo = (Sessao*)malloc(sizeof(Sessao));
+    if (modelo == NULL) {
+        printf("Erro ao alocar memória para a sessão!\n");
+        exit(1);
+    }
+    iniciarSessao(modelo, hash, mansao, &abertura, NULL);
+    liberarSessao(modelo);
+    servidor.livres[servidor.totalLivres++] = modelo;
+    servidor.abertura = abertura.dados;
     
-    int quantidadePistas = contarPistasPorSuspeito(arvorePistas, hash, acusado);
+    printf("🕵️  Servidor Detective Quest em %s (Ctrl+C encerra)\n", caminho);
+    fflush(stdout);
     
-    printf("\n📊 Resultado da análise:\n");
-    printf("   Pistas apontando para %s: %d\n\n", acusado, quantidadePistas);
+    struct epoll_event eventos[MAX_EVENTOS];
+    while (servidorAtivo) {
+        int prontos = epoll_wait(servidor.epoll, eventos, MAX_EVENTOS, -1);
+        if (prontos < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            printf("Erro: epoll_wait falhou: %s\n", strerror(errno));
+            break;
+        }
+        
+        for (int i = 0; i < prontos; i++) {
+            Conexao *conexao = (Conexao*)eventos[i].data.ptr;
+            if (conexao == NULL) {
+                aceitarConexoes(&servidor);
+            } else if (eventos[i].events & (EPOLLERR | EPOLLHUP) && !(eventos[i].events & EPOLLIN)) {
+                fecharConexao(&servidor, conexao);
+            } else {
+                atualizarConexao(&servidor, conexao);
+            }
+        }
+    }
     
-    if (quantidadePistas >= 2) {
-        printf("✅ CASO RESOLVIDO!\n\n");
-        printf("   Há evidências suficientes (%d pistas) para\n", quantidadePistas);
-        printf("   sustentar a acusação contra %s.\n\n", acusado);
-        printf("   🎉 Parabéns, detetive! O culpado foi capturado!\n");
-    } else if (quantidadePistas == 1) {
-        printf("⚠️  EVIDÊNCIAS INSUFICIENTES!\n\n");
-        printf("   Apenas 1 pista aponta para %s.\n", acusado);
-        printf("   São necessárias pelo menos 2 pistas para\n");
-        printf("   uma acusação conclusiva.\n\n");
-        printf("   O caso permanece em aberto...\n");
-    } else {
-        printf("❌ ACUSAÇÃO INCORRETA!\n\n");
-        printf("   Nenhuma pista aponta para %s.\n", acusado);
-        printf("   Revise as evidências com mais atenção.\n\n");
-        printf("   O verdadeiro culpado permanece livre...\n");
+    while (servidor.conexoes != NULL) {
+        fecharConexao(&servidor, servidor.conexoes);
     }
+    while (servidor.totalLivres > 0) {
+        free(servidor.livres[--servidor.totalLivres]);
+    }
+    free(servidor.abertura);
+    close(servidor.epoll);
+    close(servidor.escuta);
+    unlink(caminho);
+    printf("\nServidor encerrado: %lu partidas concluídas.\n", servidor.atendidas);
 }
 
 /*
- * Função: liberarArvore
- * Descrição: Libera memória da árvore de salas
- */
-void liberarArvore(Sala *raiz) {
-    if (raiz == NULL) return;
-    liberarArvore(raiz->esquerda);
-    liberarArvore(raiz->direita);
-    free(raiz);
-}
-
-/*
- * Função: liberarArvorePistas
- * Descrição: Libera memória da árvore de pistas
- */
-void liberarArvorePistas(PistaNode *raiz) {
-    if (raiz == NULL) return;
-    liberarArvorePistas(raiz->esquerda);
-    liberarArvorePistas(raiz->direita);
-    free(raiz);
-}
-
-/*
- * Função: liberarHash
- * Descrição: Libera memória da tabela hash
+ * Função: main
+ * Descrição: Função principal que integra todos os sistemas.
+ *            Uso: detective-quest_mestre [--servidor SOCKET] [--gravar REGISTRO]
+ *                                        [--repetir REGISTRO [--vezes N]]
+ *                                        [--planejar] [--mansao MANSAO] [CATALOGO]
  */
-void liberarHash(TabelaHash *hash) {
-    for (int i = 0; i < TAMANHO_HASH; i++) {
-        HashNode *atual = hash->tabela[i];
-        while (atual != NULL) {
-            HashNode *temp = atual;
-            atual = atual->proximo;
-            free(temp);
+int main(int argc, char *argv[]) {
+    setvbuf(stdout, bufferSaida, isatty(STDOUT_FILENO) ? _IOLBF : _IOFBF, sizeof(bufferSaida));
+    PERFIL_INICIAR();
+    
+    const char *caminhoSocket = NULL;
+    const char *caminhoCatalogo = NULL;
+    const char *caminhoGravacao = NULL;
+    const char *caminhoRepeticao = NULL;
+    const char *caminhoMansao = NULL;
+    int vezes = 1;
+    int planejar = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--servidor") == 0 && i + 1 < argc) {
+            caminhoSocket = argv[++i];
+        } else if (strcmp(argv[i], "--gravar") == 0 && i + 1 < argc) {
+            caminhoGravacao = argv[++i];
+        } else if (strcmp(argv[i], "--repetir") == 0 && i + 1 < argc) {
+            caminhoRepeticao = argv[++i];
+        } else if (strcmp(argv[i], "--vezes") == 0 && i + 1 < argc) {
+            vezes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mansao") == 0 && i + 1 < argc) {
+            caminhoMansao = argv[++i];
+        } else if (strcmp(argv[i], "--planejar") == 0) {
+            planejar = 1;
+        } else {
+            caminhoCatalogo = argv[i];
         }
     }
-}
-
-/*
- * Função: main
- * Descrição: Função principal que integra todos os sistemas
- */
-int main() {
-    printf("==============================================\n");
-    printf("     DETECTIVE QUEST - ENIGMA STUDIOS\n");
-    printf("          Capítulo Final\n");
-    printf("==============================================\n");
-    printf("\n🕵️  Uma mansão misteriosa...\n");
-    printf("   Pistas escondidas...\n");
-    printf("   E um culpado a ser desmascarado!\n\n");
-    printf("   Sua missão: explorar, coletar evidências\n");
-    printf("   e fazer justiça!\n");
-    
-    // Inicializa estruturas de dados
-    PistaNode *arvorePistas = NULL;
-    TabelaHash hash;
-    inicializarHash(&hash);
-    
-    // Popula a tabela hash com associações pista-suspeito
-    inserirNaHash(&hash, "Pegadas molhadas no tapete", "Jardineiro");
-    inserirNaHash(&hash, "Faca desaparecida do bloco", "Cozinheiro");
-    inserirNaHash(&hash, "Livro aberto sobre venenos", "Mordomo");
-    inserirNaHash(&hash, "Frasco vazio de arsenico", "Mordomo");
-    inserirNaHash(&hash, "Documento queimado parcialmente", "Advogado");
-    inserirNaHash(&hash, "Carta ameacadora escondida", "Advogado");
-    inserirNaHash(&hash, "Testamento adulterado", "Advogado");
-    inserirNaHash(&hash, "Planta venenosa cultivada", "Jardineiro");
-    
-    // Cria o mapa da mansão
-    Sala *hall = criarSala("Hall de Entrada");
-    Sala *salaEstar = criarSala("Sala de Estar");
-    Sala *cozinha = criarSala("Cozinha");
-    hall->esquerda = salaEstar;
-    hall->direita = cozinha;
-    
-    Sala *biblioteca = criarSala("Biblioteca");
-    Sala *escritorio = criarSala("Escritorio");
-    salaEstar->esquerda = biblioteca;
-    salaEstar->direita = escritorio;
-    
-    Sala *despensa = criarSala("Despensa");
-    Sala *jardim = criarSala("Jardim");
-    cozinha->esquerda = despensa;
-    cozinha->direita = jardim;
-    
-    Sala *salaSecreta = criarSala("Sala Secreta");
-    Sala *salaLeitura = criarSala("Sala de Leitura");
-    biblioteca->esquerda = salaSecreta;
-    biblioteca->direita = salaLeitura;
-    
-    Sala *cofre = criarSala("Cofre");
-    escritorio->esquerda = cofre;
-    
-    Sala *estufa = criarSala("Estufa");
-    jardim->direita = estufa;
-    
-    // Fase 1: Exploração
-    explorarSalas(hall, &arvorePistas);
-    
-    // Fase 2: Julgamento
-    verificarSuspeitoFinal(arvorePistas, &hash);
     
-    // Libera memória
-    liberarArvore(hall);
-    liberarArvorePistas(arvorePistas);
-    liberarHash(&hash);
+    // Mansão e tabela hash vêm prontas do cenário padrão; um catálogo
+    // passado na linha de comando substitui as associações padrão, e um
+    // arquivo de mansão, o mapa
+    TabelaHash catalogo;
+    CargaCatalogo carga;
+    const TabelaHash *hash = &hashPadrao;
+    GrafoMansao mansaoMontada = { .memoria = NULL };
+    const GrafoMansao *mansao = &mansaoPadrao;
+    
+    reconstruirFiltro(&hashPadrao);
+    if (caminhoCatalogo != NULL) {
+        carregarCatalogo(&catalogo, caminhoCatalogo, &carga);
+        hash = &catalogo;
+        printf("📚 Catálogo carregado: %d pistas, %d suspeitos, %d associações\n\n",
+               catalogo.totalPistas, catalogo.totalSuspeitos, catalogo.totalEvidencias);
+    }
+    if (caminhoMansao != NULL) {
+        carregarMansao(&mansaoMontada, caminhoMansao);
+        mansao = &mansaoMontada;
+        printf("🏚️  Mansão carregada: %d salas, %d portas\n\n", mansao->totalSalas, mansao->totalPortas);
+    } else if (hash != &hashPadrao) {
+        // O quadro e as rotas da mansão padrão valem só para o catálogo
+        // padrão; com outro, são montados numa cópia, e a padrão fica intacta
+        mansaoMontada = mansaoPadrao;
+        mansao = &mansaoMontada;
+    }
+    if (mansao == &mansaoMontada) {
+        montarQuadroEvidencias(&mansaoMontada, hash);
+        montarArvoreRotas(&mansaoMontada, hash);
+    }
     
-    printf("\n==============================================\n");
-    printf("   Obrigado por jogar Detective Quest!\n");
-    printf("==============================================\n");
+    Gravador gravador;
+    if (caminhoGravacao != NULL) {
+        abrirGravador(&gravador, caminhoGravacao);
+    }
     
-    return 0;
-}
\ No newline at end of file
+    int resultado = 0;
+    if (planejar) {
+        exibirPlanos(mansao, hash);
+    } else if (caminhoRepeticao != NULL) {
+        resultado = repetirRegistro(caminhoRepeticao, hash, mansao, vezes > 0 ? vezes : 1) ? 0 : 1;
+    } else if (caminhoSocket != NULL) {
+        executarServidor(caminhoSocket, hash, mansao, caminhoGravacao != NULL ? &gravador : NULL);
+    } else {
+        // Partida local: a mesma sessão do servidor, alimentada pela entrada padrão
+        Saida saida = { .arquivo = stdout };
+        Sessao sessao;
+        char linha[TAMANHO_LINHA];
+        
+        iniciarSessao(&sessao, hash, mansao, &saida, caminhoGravacao != NULL ? &gravador : NULL);
+        while (sessao.fase != FASE_ENCERRADA) {
+            receberLinha(&sessao, lerLinha(linha, sizeof(linha)) ? linha : NULL);
+        }
+        liberarSessao(&sessao);
+    }
+    
+    if (caminhoGravacao != NULL) {
+        fecharGravador(&gravador);
+    }
+    
+    // Libera memória
+    PERFIL_FILTRO(hash);
+    if (hash == &catalogo) {
+        liberarHash(&catalogo);
+    }
+    if (mansao == &mansaoMontada) {
+        liberarMansao(&mansaoMontada);
+    }
+    
+    return resultado;
+}
@@ -4,45 +4,47 @@
  * 
  * Este programa simula a exploração de uma mansão representada
  * por uma árvore binária, onde cada nó representa um cômodo.
+ * A árvore é gerada pelas macros de estruturas.h.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "estruturas.h"
+
 // Definição da estrutura que representa cada sala da mansão
-typedef struct Sala {
-    char nome[50];           // Nome do cômodo
-    struct Sala *esquerda;   // Ponteiro para sala à esquerda
-    struct Sala *direita;    // Ponteiro para sala à direita
-} Sala;
+DEFINIR_ARVORE_BINARIA(Sala, sala,
+    const char *nome;        // Nome do cômodo (literal em memória somente leitura)
+)
 
-/*
- * Função: criarSala
- * Descrição: Cria dinamicamente uma nova sala com o nome especificado
- * Parâmetros:
- *   - nome: string com o nome do cômodo
- * Retorno: ponteiro para a sala criada
- */
-Sala* criarSala(const char *nome) {
-    // Aloca memória dinamicamente para a nova sala
-    Sala *novaSala = (Sala*)malloc(sizeof(Sala));
-    
-    // Verifica se a alocação foi bem-sucedida
-    if (novaSala == NULL) {
-        printf("Erro ao alocar memória!\n");
-        exit(1);
-    }
-    
-    // Copia o nome para a estrutura
-    strcpy(novaSala->nome, nome);
-    
-    // Inicializa os ponteiros como NULL (sem salas conectadas)
-    novaSala->esquerda = NULL;
-    novaSala->direita = NULL;
-    
-    return novaSala;
-}
+// Índices das salas na tabela da mansão
+enum {
+    HALL, SALA_ESTAR, COZINHA,
+    BIBLIOTECA, ESCRITORIO, DESPENSA, JARDIM,
+    SALA_SECRETA, SALA_LEITURA, COFRE, ESTUFA,
+    TOTAL_SALAS
+};
+
+// Mapa da mansão (árvore binária com raiz no Hall de Entrada), montado pelo
+// compilador em memória somente leitura: iniciar o jogo não aloca nada
+static const Sala mansao[TOTAL_SALAS] = {
+    // Nível 0 - Entrada
+    [HALL]         = { "Hall de Entrada", &mansao[SALA_ESTAR], &mansao[COZINHA] },
+    // Nível 1
+    [SALA_ESTAR]   = { "Sala de Estar",   &mansao[BIBLIOTECA], &mansao[ESCRITORIO] },
+    [COZINHA]      = { "Cozinha",         &mansao[DESPENSA], &mansao[JARDIM] },
+    // Nível 2
+    [BIBLIOTECA]   = { "Biblioteca",      &mansao[SALA_SECRETA], &mansao[SALA_LEITURA] },
+    [ESCRITORIO]   = { "Escritório",      &mansao[COFRE], NULL },
+    [DESPENSA]     = { "Despensa",        NULL, NULL },
+    [JARDIM]       = { "Jardim",          NULL, &mansao[ESTUFA] },
+    // Nível 3
+    [SALA_SECRETA] = { "Sala Secreta",    NULL, NULL },
+    [SALA_LEITURA] = { "Sala de Leitura", NULL, NULL },
+    [COFRE]        = { "Cofre",           NULL, NULL },
+    [ESTUFA]       = { "Estufa",          NULL, NULL },
+};
 
 /*
  * Função: explorarSalas
@@ -51,7 +53,7 @@ Sala* criarSala(const char *nome) {
  *   - salaAtual: ponteiro para a sala onde o jogador está no momento
  * Retorno: void
  */
-void explorarSalas(Sala *salaAtual) {
+void explorarSalas(const Sala *salaAtual) {
     char escolha;
     
     // Loop principal de exploração
@@ -62,7 +64,7 @@ void explorarSalas(Sala *salaAtual) {
         printf("================================================\n");
         
         // Verifica se é uma sala sem saídas (nó-folha)
-        if (salaAtual->esquerda == NULL && salaAtual->direita == NULL) {
+        if (sala_ehFolha(salaAtual)) {
             printf("\nEsta sala não possui mais caminhos!\n");
             printf("Fim da exploração.\n");
             break;
@@ -109,30 +111,10 @@ void explorarSalas(Sala *salaAtual) {
     }
 }
 
-/*
- * Função: liberarArvore
- * Descrição: Libera toda a memória alocada para a árvore
- * Parâmetros:
- *   - raiz: ponteiro para a raiz da árvore
- * Retorno: void
- */
-void liberarArvore(Sala *raiz) {
-    if (raiz == NULL) {
-        return;
-    }
-    
-    // Libera recursivamente as subárvores
-    liberarArvore(raiz->esquerda);
-    liberarArvore(raiz->direita);
-    
-    // Libera o nó atual
-    free(raiz);
-}
-
 /*
  * Função: main
- * Descrição: Ponto de entrada do programa. Cria o mapa da mansão
- *            e inicia a exploração
+ * Descrição: Ponto de entrada do programa. Inicia a exploração
+ *            pelo mapa estático da mansão
  * Retorno: 0 se execução bem-sucedida
  */
 int main() {
@@ -142,52 +124,12 @@ int main() {
     printf("\nBem-vindo à mansão misteriosa!\n");
     printf("Explore os cômodos para encontrar pistas...\n");
     
-    // Criação da estrutura da mansão (árvore binária)
-    
-    // Nível 0 - Entrada
-    Sala *hall = criarSala("Hall de Entrada");
-    
-    // Nível 1
-    Sala *salaEstar = criarSala("Sala de Estar");
-    Sala *cozinha = criarSala("Cozinha");
-    hall->esquerda = salaEstar;
-    hall->direita = cozinha;
-    
-    // Nível 2 - Ramificações da Sala de Estar
-    Sala *biblioteca = criarSala("Biblioteca");
-    Sala *escritorio = criarSala("Escritório");
-    salaEstar->esquerda = biblioteca;
-    salaEstar->direita = escritorio;
-    
-    // Nível 2 - Ramificações da Cozinha
-    Sala *despensa = criarSala("Despensa");
-    Sala *jardim = criarSala("Jardim");
-    cozinha->esquerda = despensa;
-    cozinha->direita = jardim;
-    
-    // Nível 3 - Ramificações da Biblioteca
-    Sala *salaSecreta = criarSala("Sala Secreta");
-    Sala *salaLeitura = criarSala("Sala de Leitura");
-    biblioteca->esquerda = salaSecreta;
-    biblioteca->direita = salaLeitura;
-    
-    // Nível 3 - Ramificações do Escritório
-    Sala *cofre = criarSala("Cofre");
-    escritorio->esquerda = cofre;
-    
-    // Nível 3 - Ramificações do Jardim
-    Sala *estufa = criarSala("Estufa");
-    jardim->direita = estufa;
-    
     // Inicia a exploração a partir do Hall de Entrada
-    explorarSalas(hall);
-    
-    // Libera toda a memória alocada
-    liberarArvore(hall);
+    explorarSalas(&mansao[HALL]);
     
     printf("\n==============================================\n");
     printf("Obrigado por jogar Detective Quest!\n");
     printf("==============================================\n");
     
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,547 @@
+/*
+ * Detective Quest - Estruturas de Dados Compartilhadas
+ * Enigma Studios
+ *
+ * Macros que geram, para tipos escolhidos em tempo de compilação:
+ * - Árvore binária imutável (mapa da mansão)
+ * - Árvore binária de busca / mapa ordenado (diário de pistas)
+ * - Mapa ordenado persistente, com versões que compartilham nós
+ * - Consultas por posição (k-ésimo, posição, página) nos mapas ordenados
+ * - Chaves de ordenação de textos em português, comparadas com memcmp
+ * - Tabela hash com encadeamento (catálogo de pistas)
+ *
+ * Cada instância gera structs e funções próprias, com comparação e hash
+ * expandidos direto no código: sem void* nem ponteiros para função.
+ * Nos mapas, os campos de dados ficam depois dos ponteiros, para que o
+ * último possa ser um vetor flexível (ex.: char texto[]) alocado junto
+ * com o nó no tamanho exato da chave.
+ * As funções são static inline, então instâncias não usadas não geram
+ * código nem avisos.
+ */
+
+#ifndef ESTRUTURAS_H
+#define ESTRUTURAS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Texto com a chave de ordenação já montada, para inserir ou procurar em
+// um mapa ordenado alfabeticamente
+typedef struct {
+    const char *texto;
+    const char *chave;              // Chave de montarChaveOrdem (sem \0)
+    unsigned int tamanho;           // strlen(texto)
+    unsigned int tamanhoChave;
+} TextoOrdenado;
+
+/*
+ * Função: montarChaveOrdem
+ * Descrição: Escreve em destino a chave de ordenação de um texto UTF-8:
+ *            letras em minúsculas e sem acento (Á, ã, Ç... viram a, a,
+ *            c), os demais bytes como estão. Chaves comparadas com memcmp
+ *            seguem a ordem alfabética do português, em que "ameaçadora"
+ *            vem antes de "ameaças" e "Escritório" fica junto de
+ *            "escritorio", e não depois de todo o "z" como no strcmp.
+ *            Só são dobradas as maiúsculas ASCII e as sequências de dois
+ *            bytes 0xC3 xx (U+00C0 a U+00FF, que cobrem o português);
+ *            outras letras acentuadas (ő, ł...) e acentos combinantes
+ *            (U+0301...) ficam como estão e ordenam pelos bytes.
+ * Parâmetros:
+ *   - texto: texto terminado em \0
+ *   - destino: recebe a chave (capacidade de strlen(texto) bytes)
+ * Retorno: tamanho da chave (nunca maior que o do texto)
+ */
+static inline unsigned int montarChaveOrdem(const char *texto, char *destino) {
+    // Segundo byte de U+00C0 a U+00FF (primeiro byte 0xC3): letra sem
+    // acento, ou \0 para os símbolos, que ficam como estão
+    static const char semAcento[] = "aaaaaa\0ceeeeiiii\0nooooo\0ouuuuy\0\0"
+                                    "aaaaaa\0ceeeeiiii\0nooooo\0ouuuuy\0y";
+    const unsigned char *c = (const unsigned char*)texto;
+    unsigned int tamanho = 0;
+    
+    while (*c != '\0') {
+        if (*c >= 'A' && *c <= 'Z') {
+            destino[tamanho++] = (char)(*c++ - 'A' + 'a');
+        } else if (*c == 0xC3 && c[1] >= 0x80 && c[1] <= 0xBF && semAcento[c[1] - 0x80] != '\0') {
+            destino[tamanho++] = semAcento[c[1] - 0x80];
+            c += 2;
+        } else {
+            destino[tamanho++] = (char)*c++;
+        }
+    }
+    return tamanho;
+}
+
+#define TAMANHO_CHAVE_LOCAL 256 // Chave de ordenação montada sem alocação por ordenarTexto
+
+/*
+ * Função: ordenarTexto
+ * Descrição: Prepara um texto para um mapa ordenado alfabeticamente. A
+ *            chave vai para local se couber; senão é alocada, e
+ *            soltarTextoOrdenado a libera.
+ */
+static inline void ordenarTexto(TextoOrdenado *ordenado, const char *texto,
+                                char *local, size_t capacidadeLocal) {
+    size_t tamanho = strlen(texto);
+    char *chave = tamanho <= capacidadeLocal ? local : (char*)malloc(tamanho);
+    
+    if (chave == NULL) {
+        printf("Erro ao alocar memória!\n");
+        exit(1);
+    }
+    ordenado->texto = texto;
+    ordenado->chave = chave;
+    ordenado->tamanho = (unsigned int)tamanho;
+    ordenado->tamanhoChave = montarChaveOrdem(texto, chave);
+}
+
+static inline void soltarTextoOrdenado(TextoOrdenado *ordenado, const char *local) {
+    if (ordenado->chave != local) {
+        free((char*)ordenado->chave);
+    }
+}
+
+// Ordem alfabética: chaves com memcmp (a mais curta primeiro) e, só entre
+// textos de mesma chave (acentos ou maiúsculas diferentes), os bytes
+static inline int compararTextosOrdenados(const TextoOrdenado *a, const TextoOrdenado *b) {
+    unsigned int menor = a->tamanhoChave < b->tamanhoChave ? a->tamanhoChave : b->tamanhoChave;
+    int comparacao = memcmp(a->chave, b->chave, menor);
+    
+    if (comparacao == 0) {
+        comparacao = a->tamanhoChave != b->tamanhoChave ? (a->tamanhoChave < b->tamanhoChave ? -1 : 1)
+                                                        : strcmp(a->texto, b->texto);
+    }
+    return comparacao;
+}
+
+/*
+ * Macro: DEFINIR_ARVORE_BINARIA
+ * Descrição: Gera uma árvore binária imutável, pensada para tabelas
+ *            estáticas (os filhos são ponteiros const)
+ * Parâmetros:
+ *   - Tipo: nome da struct do nó
+ *   - prefixo: prefixo das funções geradas
+ *   - CAMPOS: declaração dos campos de dados, que ficam antes dos filhos
+ * Gera:
+ *   - prefixo_ehFolha(no)
+ */
+#define DEFINIR_ARVORE_BINARIA(Tipo, prefixo, CAMPOS)                                \
+    typedef struct Tipo {                                                            \
+        CAMPOS                                                                       \
+        const struct Tipo *esquerda;                                                 \
+        const struct Tipo *direita;                                                  \
+    } Tipo;                                                                          \
+                                                                                     \
+    /* Verdadeiro se o nó não tem filhos */                                          \
+    static inline int prefixo##_ehFolha(const Tipo *no) {                            \
+        return no->esquerda == NULL && no->direita == NULL;                          \
+    }
+
+/*
+ * Macro: DEFINIR_ESTATISTICAS_DE_ORDEM
+ * Descrição: Consultas por posição em uma árvore de busca cujos nós
+ *            guardam em nos o tamanho da própria subárvore (instanciada
+ *            pelos mapas ordenados abaixo). Custam O(altura), mais os
+ *            nós copiados na página.
+ * Parâmetros:
+ *   - Tipo, prefixo, TipoChave, COMPARAR: os mesmos do mapa
+ * Gera:
+ *   - prefixo_contar(raiz): total de nós, lido da raiz
+ *   - prefixo_selecionar(raiz, k): k-ésimo nó em ordem (0 = menor), ou
+ *     NULL se k está fora da árvore
+ *   - prefixo_posicao(raiz, chave): quantas chaves vêm antes da chave
+ *     (esteja ela na árvore ou não)
+ *   - prefixo_pagina(raiz, inicio, quantidade, pagina): copia para
+ *     pagina até quantidade nós, em ordem, a partir da posição inicio;
+ *     retorna quantos copiou
+ */
+#define DEFINIR_ESTATISTICAS_DE_ORDEM(Tipo, prefixo, TipoChave, COMPARAR)            \
+    static inline int prefixo##_contar(const Tipo *raiz) {                           \
+        return raiz != NULL ? (int)raiz->nos : 0;                                    \
+    }                                                                                \
+                                                                                     \
+    static inline const Tipo *prefixo##_selecionar(const Tipo *raiz, int k) {        \
+        while (raiz != NULL) {                                                       \
+            int antes = prefixo##_contar(raiz->esquerda);                            \
+            if (k == antes) {                                                        \
+                return raiz;                                                         \
+            }                                                                        \
+            if (k < antes) {                                                         \
+                raiz = raiz->esquerda;                                               \
+            } else {                                                                 \
+                k -= antes + 1;                                                      \
+                raiz = raiz->direita;                                                \
+            }                                                                        \
+        }                                                                            \
+        return NULL;                                                                 \
+    }                                                                                \
+                                                                                     \
+    static inline int prefixo##_posicao(const Tipo *raiz, TipoChave chave) {         \
+        int posicao = 0;                                                             \
+        while (raiz != NULL) {                                                       \
+            int comparacao = COMPARAR(chave, raiz);                                  \
+            if (comparacao <= 0) {                                                   \
+                if (comparacao == 0) {                                               \
+                    return posicao + prefixo##_contar(raiz->esquerda);               \
+                }                                                                    \
+                raiz = raiz->esquerda;                                               \
+            } else {                                                                 \
+                posicao += prefixo##_contar(raiz->esquerda) + 1;                     \
+                raiz = raiz->direita;                                                \
+            }                                                                        \
+        }                                                                            \
+        return posicao;                                                              \
+    }                                                                                \
+                                                                                     \
+    /* Desce pulando as subárvores inteiras antes de inicio; só a esquerda           \
+       que contém o início da página é visitada recursivamente */                    \
+    static inline int prefixo##_pagina(const Tipo *raiz, int inicio, int quantidade, \
+                                       const Tipo *pagina[]) {                       \
+        int total = 0;                                                               \
+        while (raiz != NULL && total < quantidade) {                                 \
+            int antes = prefixo##_contar(raiz->esquerda);                            \
+            if (inicio <= antes) {                                                   \
+                if (inicio < antes) {                                                \
+                    total += prefixo##_pagina(raiz->esquerda, inicio,                \
+                                              quantidade - total, pagina + total);   \
+                }                                                                    \
+                if (total < quantidade) {                                            \
+                    pagina[total++] = raiz;                                          \
+                }                                                                    \
+                inicio = 0;                                                          \
+            } else {                                                                 \
+                inicio -= antes + 1;                                                 \
+            }                                                                        \
+            raiz = raiz->direita;                                                    \
+        }                                                                            \
+        return total;                                                                \
+    }
+
+/*
+ * Macro: DEFINIR_MAPA_ORDENADO
+ * Descrição: Gera uma árvore binária de busca sem duplicatas
+ * Parâmetros:
+ *   - Tipo: nome da struct do nó
+ *   - prefixo: prefixo das funções geradas
+ *   - CAMPOS: declaração dos campos de chave e valor (depois dos filhos)
+ *   - TipoChave: tipo usado para inserir e buscar
+ *   - COMPARAR(chave, no): expressão <0, 0 ou >0, como strcmp
+ *   - TAMANHO_EXTRA(chave): bytes alocados além de sizeof(Tipo)
+ *   - INICIAR(no, chave): preenche a chave de um nó recém-alocado
+ * Gera:
+ *   - prefixo_inserir(raiz, chave, &inserido): retorna a nova raiz;
+ *     inserido recebe o nó criado, ou NULL se a chave já existia
+ *   - prefixo_buscar(raiz, chave)
+ *   - prefixo_liberar(raiz): retorna quantos nós foram liberados
+ *   - as consultas de DEFINIR_ESTATISTICAS_DE_ORDEM (contar em O(1))
+ */
+#define DEFINIR_MAPA_ORDENADO(Tipo, prefixo, CAMPOS, TipoChave, COMPARAR,            \
+                              TAMANHO_EXTRA, INICIAR)                                \
+    typedef struct Tipo {                                                            \
+        struct Tipo *esquerda;                                                       \
+        struct Tipo *direita;                                                        \
+        unsigned int nos;           /* Nós da subárvore, contando este */            \
+        CAMPOS                                                                       \
+    } Tipo;                                                                          \
+                                                                                     \
+    DEFINIR_ESTATISTICAS_DE_ORDEM(Tipo, prefixo, TipoChave, COMPARAR)                \
+                                                                                     \
+    static inline Tipo *prefixo##_inserir(Tipo *raiz, TipoChave chave,               \
+                                          Tipo **inserido) {                         \
+        if (raiz == NULL) {                                                          \
+            Tipo *novo = (Tipo*)malloc(sizeof(Tipo) + (TAMANHO_EXTRA(chave)));       \
+            if (novo == NULL) {                                                      \
+                printf("Erro ao alocar memória!\n");                                 \
+                exit(1);                                                             \
+            }                                                                        \
+            INICIAR(novo, chave);                                                    \
+            novo->esquerda = NULL;                                                   \
+            novo->direita = NULL;                                                    \
+            novo->nos = 1;                                                           \
+            *inserido = novo;                                                        \
+            return novo;                                                             \
+        }                                                                            \
+        int comparacao = COMPARAR(chave, raiz);                                      \
+        if (comparacao < 0) {                                                        \
+            raiz->esquerda = prefixo##_inserir(raiz->esquerda, chave, inserido);     \
+        } else if (comparacao > 0) {                                                 \
+            raiz->direita = prefixo##_inserir(raiz->direita, chave, inserido);       \
+        } else {                                                                     \
+            *inserido = NULL;  /* Chave já existe */                                 \
+        }                                                                            \
+        if (*inserido != NULL) {                                                     \
+            raiz->nos++;                                                             \
+        }                                                                            \
+        return raiz;                                                                 \
+    }                                                                                \
+                                                                                     \
+    static inline Tipo *prefixo##_buscar(Tipo *raiz, TipoChave chave) {              \
+        while (raiz != NULL) {                                                       \
+            int comparacao = COMPARAR(chave, raiz);                                  \
+            if (comparacao == 0) {                                                   \
+                return raiz;                                                         \
+            }                                                                        \
+            raiz = comparacao < 0 ? raiz->esquerda : raiz->direita;                  \
+        }                                                                            \
+        return NULL;                                                                 \
+    }                                                                                \
+                                                                                     \
+    static inline int prefixo##_liberar(Tipo *raiz) {                                \
+        if (raiz == NULL) {                                                          \
+            return 0;                                                                \
+        }                                                                            \
+        int liberados = prefixo##_liberar(raiz->esquerda)                            \
+                      + prefixo##_liberar(raiz->direita);                            \
+        free(raiz);                                                                  \
+        return liberados + 1;                                                        \
+    }
+
+/*
+ * Macro: DEFINIR_MAPA_PERSISTENTE
+ * Descrição: Gera um mapa ordenado persistente (treap com cópia de
+ *            caminho). Inserir não altera a versão recebida: devolve uma
+ *            nova raiz que compartilha todos os nós fora do caminho da
+ *            inserção, então cada versão custa O(log n) nós novos.
+ *            Os nós têm contagem de referências; cada raiz devolvida por
+ *            inserir é uma referência do chamador, solta com soltar.
+ * Parâmetros:
+ *   - Tipo: nome da struct do nó
+ *   - prefixo: prefixo das funções geradas
+ *   - CAMPOS: declaração dos campos de chave e valor (depois dos filhos)
+ *   - TipoChave: tipo usado para inserir e buscar
+ *   - COMPARAR(chave, no): expressão <0, 0 ou >0, como strcmp
+ *   - CHAVE(no): chave guardada no nó, como TipoChave
+ *   - PRIORIDADE(chave): hash da chave, usado como prioridade do treap
+ *   - TAMANHO_EXTRA(chave): bytes alocados além de sizeof(Tipo)
+ *   - INICIAR(no, chave): preenche a chave de um nó recém-alocado
+ * Gera:
+ *   - prefixo_inserir(raiz, chave, &inserido): nova versão; inserido
+ *     recebe o nó criado, ou NULL se a chave já existia (e a versão
+ *     devolvida é a própria raiz, com mais uma referência)
+ *   - prefixo_reter(raiz) / prefixo_soltar(raiz): soltar retorna
+ *     quantos nós foram liberados
+ *   - prefixo_buscar(raiz, chave)
+ *   - as consultas de DEFINIR_ESTATISTICAS_DE_ORDEM (contar em O(1)),
+ *     válidas em qualquer versão
+ */
+#define DEFINIR_MAPA_PERSISTENTE(Tipo, prefixo, CAMPOS, TipoChave, COMPARAR, CHAVE,  \
+                                 PRIORIDADE, TAMANHO_EXTRA, INICIAR)                 \
+    typedef struct Tipo {                                                            \
+        struct Tipo *esquerda;                                                       \
+        struct Tipo *direita;                                                        \
+        unsigned int referencias;   /* Versões e pais que apontam para o nó */       \
+        unsigned int prioridade;    /* Prioridade do treap (heap máximo) */          \
+        unsigned int nos;           /* Nós da subárvore, contando este */            \
+        CAMPOS                                                                       \
+    } Tipo;                                                                          \
+                                                                                     \
+    DEFINIR_ESTATISTICAS_DE_ORDEM(Tipo, prefixo, TipoChave, COMPARAR)                \
+                                                                                     \
+    static inline Tipo *prefixo##_reter(Tipo *raiz) {                                \
+        if (raiz != NULL) {                                                          \
+            raiz->referencias++;                                                     \
+        }                                                                            \
+        return raiz;                                                                 \
+    }                                                                                \
+                                                                                     \
+    static inline int prefixo##_soltar(Tipo *raiz) {                                 \
+        if (raiz == NULL || --raiz->referencias > 0) {                               \
+            return 0;                                                                \
+        }                                                                            \
+        int liberados = prefixo##_soltar(raiz->esquerda)                             \
+                      + prefixo##_soltar(raiz->direita);                             \
+        free(raiz);                                                                  \
+        return liberados + 1;                                                        \
+    }                                                                                \
+                                                                                     \
+    static inline Tipo *prefixo##_alocar(size_t tamanho) {                           \
+        Tipo *novo = (Tipo*)malloc(tamanho);                                         \
+        if (novo == NULL) {                                                          \
+            printf("Erro ao alocar memória!\n");                                     \
+            exit(1);                                                                 \
+        }                                                                            \
+        return novo;                                                                 \
+    }                                                                                \
+                                                                                     \
+    /* Devolve a subárvore com a chave inserida, formada só por nós novos            \
+       (exclusivos do chamador) no caminho, ou NULL se a chave já existe */          \
+    static inline Tipo *prefixo##_inserirCopiando(Tipo *raiz, TipoChave chave,       \
+                                                  Tipo **inserido) {                 \
+        if (raiz == NULL) {                                                          \
+            Tipo *novo = prefixo##_alocar(sizeof(Tipo) + (TAMANHO_EXTRA(chave)));    \
+            INICIAR(novo, chave);                                                    \
+            novo->esquerda = NULL;                                                   \
+            novo->direita = NULL;                                                    \
+            novo->referencias = 1;                                                   \
+            novo->prioridade = PRIORIDADE(chave);                                    \
+            novo->nos = 1;                                                           \
+            *inserido = novo;                                                        \
+            return novo;                                                             \
+        }                                                                            \
+        int comparacao = COMPARAR(chave, raiz);                                      \
+        if (comparacao == 0) {                                                       \
+            *inserido = NULL;                                                        \
+            return NULL;                                                             \
+        }                                                                            \
+        Tipo *filho = prefixo##_inserirCopiando(                                     \
+            comparacao < 0 ? raiz->esquerda : raiz->direita, chave, inserido);       \
+        if (filho == NULL) {                                                         \
+            return NULL;                                                             \
+        }                                                                            \
+                                                                                     \
+        /* Copia o nó do caminho; o filho não alterado ganha mais um pai.            \
+           Na rotação, o filho (novo) assume o tamanho total e a cópia               \
+           recalcula o seu pelos filhos que lhe restaram */                          \
+        size_t tamanho = sizeof(Tipo) + (TAMANHO_EXTRA(CHAVE(raiz)));                \
+        Tipo *copia = prefixo##_alocar(tamanho);                                     \
+        memcpy(copia, raiz, tamanho);                                                \
+        copia->referencias = 1;                                                      \
+        copia->nos++;                                                                \
+        if (comparacao < 0) {                                                        \
+            prefixo##_reter(copia->direita);                                         \
+            copia->esquerda = filho;                                                 \
+            if (filho->prioridade > copia->prioridade) {  /* Rotação à direita */    \
+                copia->esquerda = filho->direita;                                    \
+                filho->direita = copia;                                              \
+                filho->nos = copia->nos;                                             \
+                copia->nos = 1 + prefixo##_contar(copia->esquerda)                   \
+                               + prefixo##_contar(copia->direita);                   \
+                return filho;                                                        \
+            }                                                                        \
+        } else {                                                                     \
+            prefixo##_reter(copia->esquerda);                                        \
+            copia->direita = filho;                                                  \
+            if (filho->prioridade > copia->prioridade) {  /* Rotação à esquerda */   \
+                copia->direita = filho->esquerda;                                    \
+                filho->esquerda = copia;                                             \
+                filho->nos = copia->nos;                                             \
+                copia->nos = 1 + prefixo##_contar(copia->esquerda)                   \
+                               + prefixo##_contar(copia->direita);                   \
+                return filho;                                                        \
+            }                                                                        \
+        }                                                                            \
+        return copia;                                                                \
+    }                                                                                \
+                                                                                     \
+    static inline Tipo *prefixo##_inserir(Tipo *raiz, TipoChave chave,               \
+                                          Tipo **inserido) {                         \
+        Tipo *nova = prefixo##_inserirCopiando(raiz, chave, inserido);               \
+        return nova != NULL ? nova : prefixo##_reter(raiz);                          \
+    }                                                                                \
+                                                                                     \
+    static inline Tipo *prefixo##_buscar(Tipo *raiz, TipoChave chave) {              \
+        while (raiz != NULL) {                                                       \
+            int comparacao = COMPARAR(chave, raiz);                                  \
+            if (comparacao == 0) {                                                   \
+                return raiz;                                                         \
+            }                                                                        \
+            raiz = comparacao < 0 ? raiz->esquerda : raiz->direita;                  \
+        }                                                                            \
+        return NULL;                                                                 \
+    }
+
+/*
+ * Macro: DEFINIR_MAPA_HASH
+ * Descrição: Gera uma tabela hash com encadeamento e quantidade de baldes
+ *            escolhida ao inicializar. Os nós são ligados por ponteiros
+ *            const, para que tabelas inteiras possam ser montadas
+ *            estaticamente (baldes e totalBaldes preenchidos à mão).
+ * Parâmetros:
+ *   - TipoMapa: nome da struct da tabela
+ *   - TipoNo: nome da struct do nó
+ *   - prefixo: prefixo das funções geradas
+ *   - CAMPOS: declaração dos campos de chave e valor (depois do próximo)
+ *   - TipoChave: tipo usado para inserir e buscar
+ *   - HASH(chave): expressão que devolve o hash (reduzido aqui ao balde)
+ *   - IGUAL(no, chave): expressão verdadeira se o nó tem a chave
+ *   - TAMANHO_EXTRA(chave): bytes alocados além de sizeof(TipoNo)
+ *   - INICIAR(no, chave): preenche a chave de um nó recém-alocado
+ * Gera:
+ *   - prefixo_inicializar(mapa, totalBaldes)
+ *   - prefixo_balde(mapa, chave): balde onde a chave fica
+ *   - prefixo_buscarNoBalde(mapa, balde, chave)
+ *   - prefixo_buscar(mapa, chave)
+ *   - prefixo_ligar(mapa, balde, no): encadeia um nó já alocado pelo
+ *     chamador (inserção em bloco, sem malloc por nó)
+ *   - prefixo_inserir(mapa, chave): cria sempre um nó novo no balde
+ *   - prefixo_liberar(mapa): libera nós e baldes; retorna quantos nós
+ *     foram liberados (só para nós criados por prefixo_inserir)
+ */
+#define DEFINIR_MAPA_HASH(TipoMapa, TipoNo, prefixo, CAMPOS, TipoChave,              \
+                          HASH, IGUAL, TAMANHO_EXTRA, INICIAR)                       \
+    typedef struct TipoNo {                                                          \
+        const struct TipoNo *proximo;                                                \
+        CAMPOS                                                                       \
+    } TipoNo;                                                                        \
+                                                                                     \
+    typedef struct {                                                                 \
+        const TipoNo **baldes;                                                       \
+        unsigned int totalBaldes;                                                    \
+    } TipoMapa;                                                                      \
+                                                                                     \
+    static inline void prefixo##_inicializar(TipoMapa *mapa,                         \
+                                             unsigned int totalBaldes) {             \
+        mapa->baldes = (const TipoNo**)calloc(totalBaldes, sizeof(TipoNo*));         \
+        if (mapa->baldes == NULL) {                                                  \
+            printf("Erro ao alocar memória para hash!\n");                           \
+            exit(1);                                                                 \
+        }                                                                            \
+        mapa->totalBaldes = totalBaldes;                                             \
+    }                                                                                \
+                                                                                     \
+    static inline unsigned int prefixo##_balde(const TipoMapa *mapa,                 \
+                                               TipoChave chave) {                    \
+        return (HASH(chave)) % mapa->totalBaldes;                                    \
+    }                                                                                \
+                                                                                     \
+    static inline const TipoNo *prefixo##_buscarNoBalde(const TipoMapa *mapa,        \
+                                                        unsigned int balde,          \
+                                                        TipoChave chave) {           \
+        const TipoNo *atual = mapa->baldes[balde];                                   \
+        while (atual != NULL && !(IGUAL(atual, chave))) {                            \
+            atual = atual->proximo;                                                  \
+        }                                                                            \
+        return atual;                                                                \
+    }                                                                                \
+                                                                                     \
+    static inline const TipoNo *prefixo##_buscar(const TipoMapa *mapa,               \
+                                                 TipoChave chave) {                  \
+        return prefixo##_buscarNoBalde(mapa, prefixo##_balde(mapa, chave), chave);   \
+    }                                                                                \
+                                                                                     \
+    static inline void prefixo##_ligar(TipoMapa *mapa, unsigned int balde,           \
+                                       TipoNo *no) {                                 \
+        no->proximo = mapa->baldes[balde];  /* Insere no início da lista */          \
+        mapa->baldes[balde] = no;                                                    \
+    }                                                                                \
+                                                                                     \
+    static inline TipoNo *prefixo##_inserir(TipoMapa *mapa, TipoChave chave) {       \
+        TipoNo *novo = (TipoNo*)malloc(sizeof(TipoNo) + (TAMANHO_EXTRA(chave)));     \
+        if (novo == NULL) {                                                          \
+            printf("Erro ao alocar memória para hash!\n");                           \
+            exit(1);                                                                 \
+        }                                                                            \
+        INICIAR(novo, chave);                                                        \
+        prefixo##_ligar(mapa, prefixo##_balde(mapa, chave), novo);                   \
+        return novo;                                                                 \
+    }                                                                                \
+                                                                                     \
+    static inline int prefixo##_liberar(TipoMapa *mapa) {                            \
+        int liberados = 0;                                                           \
+        for (unsigned int i = 0; i < mapa->totalBaldes; i++) {                       \
+            const TipoNo *atual = mapa->baldes[i];                                   \
+            while (atual != NULL) {                                                  \
+                TipoNo *temp = (TipoNo*)atual;                                       \
+                atual = atual->proximo;                                              \
+                free(temp);                                                          \
+                liberados++;                                                         \
+            }                                                                        \
+        }                                                                            \
+        free(mapa->baldes);                                                          \
+        mapa->baldes = NULL;                                                         \
+        mapa->totalBaldes = 0;                                                       \
+        return liberados;                                                            \
+    }
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * Detective Quest - Verificação das tabelas do cenário padrão
+ * Enigma Studios
+ *
+ * O índice de nomes, a numeração das pistas, o quadro de evidências e a
+ * árvore de rotas da mansão padrão são escritos à mão no código. Este
+ * programa os monta de novo com numerarPistas, montarQuadroEvidencias e
+ * montarArvoreRotas e compara com as tabelas estáticas. Compilado e
+ * executado por testes/verificar.sh.
+ */
+
+#define main mainMestre
+#include "../detective-quest_mestre.c"
+#undef main
+
+static int diferencas = 0;
+
+// Compara dois vetores de int e conta a diferença
+static void compararVetores(const char *nome, const int *estatico, const int *montado, int total) {
+    for (int i = 0; i < total; i++) {
+        if (estatico[i] != montado[i]) {
+            printf("%s[%d]: tabela %d, montado %d\n", nome, i, estatico[i], montado[i]);
+            diferencas++;
+            return;
+        }
+    }
+}
+
+static void compararInteiros(const char *nome, int estatico, int montado) {
+    if (estatico != montado) {
+        printf("%s: tabela %d, montado %d\n", nome, estatico, montado);
+        diferencas++;
+    }
+}
+
+int main(void) {
+    const GrafoMansao *padrao = &mansaoPadrao;
+    GrafoMansao montada = mansaoPadrao;
+    int salas = padrao->totalSalas;
+
+    reconstruirFiltro(&hashPadrao);
+    numerarPistas(&montada);
+    montarQuadroEvidencias(&montada, &hashPadrao);
+    montarArvoreRotas(&montada, &hashPadrao);
+
+    // Numeração das pistas
+    compararInteiros("totalPistas", padrao->totalPistas, montada.totalPistas);
+    compararVetores("pistaDaSala", padrao->pistaDaSala, montada.pistaDaSala, salas);
+    compararVetores("inicioSalasPista", padrao->inicioSalasPista, montada.inicioSalasPista,
+                    padrao->totalPistas + 1);
+    compararVetores("salasPista", padrao->salasPista, montada.salasPista,
+                    padrao->inicioSalasPista[padrao->totalPistas]);
+
+    // Quadro de evidências
+    const QuadroEvidencias *quadro = &padrao->quadro;
+    compararInteiros("quadro.ativo", quadro->ativo, montada.quadro.ativo);
+    compararInteiros("quadro.totalPistas", quadro->totalPistas, montada.quadro.totalPistas);
+    compararInteiros("quadro.palavras", quadro->palavras, montada.quadro.palavras);
+    compararInteiros("quadro.planos", quadro->planos, montada.quadro.planos);
+    compararInteiros("quadro.totalSuspeitos", quadro->totalSuspeitos, montada.quadro.totalSuspeitos);
+    compararInteiros("quadro.colunas", quadro->colunas, montada.quadro.colunas);
+    size_t palavrasBits = (size_t)quadro->planos * (size_t)quadro->palavras * (size_t)quadro->colunas;
+    if (diferencas == 0 && memcmp(quadro->bits, montada.quadro.bits, palavrasBits * sizeof(uint64_t)) != 0) {
+        printf("quadro.bits: tabela e montado diferem\n");
+        diferencas++;
+    }
+
+    // Árvore de rotas
+    const ArvoreRotas *rotas = &padrao->rotas;
+    compararInteiros("rotas.totalOrdem", rotas->totalOrdem, montada.rotas.totalOrdem);
+    compararVetores("rotas.ordem", rotas->ordem, montada.rotas.ordem, rotas->totalOrdem);
+    compararVetores("rotas.pai", rotas->pai, montada.rotas.pai, salas);
+    compararVetores("rotas.inicioFilhos", rotas->inicioFilhos, montada.rotas.inicioFilhos, salas + 1);
+    compararVetores("rotas.filhos", rotas->filhos, montada.rotas.filhos, rotas->inicioFilhos[salas]);
+    compararVetores("rotas.pistaCatalogo", rotas->pistaCatalogo, montada.rotas.pistaCatalogo, salas);
+
+    // Índice de nomes: cada sala está no balde que salas_balde calcula, e
+    // só uma vez
+    int nos = 0;
+    for (unsigned int b = 0; b < padrao->indice.totalBaldes; b++) {
+        for (const SalaNode *no = padrao->indice.baldes[b]; no != NULL; no = no->proximo) {
+            if (salas_balde(&padrao->indice, no->nome) != b) {
+                printf("indice: \"%s\" no balde %u, esperado %u\n",
+                       no->nome, b, salas_balde(&padrao->indice, no->nome));
+                diferencas++;
+            }
+            nos++;
+        }
+    }
+    compararInteiros("indice: salas encadeadas", salas, nos);
+    for (int s = 0; s < salas; s++) {
+        const SalaNode *no = salas_buscar(&padrao->indice, padrao->nomes[s]);
+        if (no == NULL || no->id != s) {
+            printf("indice: \"%s\" não leva à sala %d\n", padrao->nomes[s], s);
+            diferencas++;
+        }
+    }
+
+    liberarMansao(&montada);
+    return diferencas > 0 ? 1 : 0;
+}
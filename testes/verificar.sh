@@ -0,0 +1,174 @@
+#!/bin/bash
+#
+# Detective Quest - Verificação do nível Mestre
+# Enigma Studios
+#
+# Compila o nível Mestre e confere:
+#   - as tabelas estáticas da mansão padrão contra as montadas em tempo de
+#     execução (tabelas_padrao.c);
+#   - a partida padrão contra a transcrição esperada (sessao_padrao.esperado);
+#   - o peso das evidências de um catálogo em que uma pista aponta para
+#     vários suspeitos, com pesos diferentes;
+#   - a gravação de uma partida em registro DQR4 e a repetição dele;
+#   - mansões carregadas em corredor, mais fundas que 64 salas e com mais
+#     de 64 pistas, atravessadas por um único goto; a maior passa de
+#     MAX_PISTAS_QUADRO pistas e é pontuada pelo CSR;
+#   - o desfazer e a dica (H) com o mesmo texto de pista em duas salas;
+#   - um histórico de 100 versões do diário, desfeito e consultado com
+#     "versao <n>";
+#
+# Uso: testes/verificar.sh
+#   - CC e CFLAGS trocam o compilador e as opções (padrão: gcc -O2 -Wall -Wextra)
+#   - ATUALIZAR=1 regrava a transcrição esperada com a saída atual
+
+set -u
+
+DIRETORIO=$(cd "$(dirname "$0")" && pwd)
+RAIZ=$(dirname "$DIRETORIO")
+TEMP=$(mktemp -d)
+trap 'rm -rf "$TEMP"' EXIT
+
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--O2 -Wall -Wextra}
+MESTRE="$TEMP/mestre"
+falhas=0
+
+ok() {
+    echo "ok - $1"
+}
+
+falhou() {
+    echo "FALHOU - $1"
+    falhas=$((falhas + 1))
+}
+
+# shellcheck disable=SC2086
+if ! $CC $CFLAGS -o "$MESTRE" "$RAIZ/detective-quest_mestre.c" -lpthread -lm; then
+    echo "FALHOU - compilação de detective-quest_mestre.c"
+    exit 1
+fi
+ok "compilação"
+
+# Tabelas da mansão padrão escritas à mão
+# shellcheck disable=SC2086
+if ! $CC $CFLAGS -o "$TEMP/tabelas" "$DIRETORIO/tabelas_padrao.c" -lpthread -lm; then
+    falhou "compilação de tabelas_padrao.c"
+elif "$TEMP/tabelas"; then
+    ok "tabelas estáticas da mansão padrão iguais às montadas"
+else
+    falhou "tabelas estáticas da mansão padrão diferem das montadas"
+fi
+
+# Partida padrão: coleta, desfazer, pistas ao alcance, goto, diário e acusação
+ENTRADA_PADRAO='E\nE\nE\nU\nP\nV\nD\ngoto Estufa\ndiario\nS\nMordomo\n'
+printf "$ENTRADA_PADRAO" | "$MESTRE" > "$TEMP/padrao.txt"
+if [ "${ATUALIZAR:-0}" = 1 ]; then
+    cp "$TEMP/padrao.txt" "$DIRETORIO/sessao_padrao.esperado"
+    ok "transcrição esperada regravada"
+elif diff -u "$DIRETORIO/sessao_padrao.esperado" "$TEMP/padrao.txt" > "$TEMP/padrao.diff"; then
+    ok "partida padrão igual à transcrição esperada"
+else
+    cat "$TEMP/padrao.diff"
+    falhou "partida padrão difere da transcrição esperada"
+fi
+
+# Evidências com pesos: as pegadas do Hall apontam para dois suspeitos e o
+# livro da Biblioteca, para um terceiro. Entrando na Biblioteca, o diário
+# tem as duas pistas.
+printf 'Pegadas molhadas no tapete\tJardineiro\t2\nPegadas molhadas no tapete\tMordomo\t1\n' > "$TEMP/pesos.tsv"
+printf 'Livro aberto sobre venenos\tMordomo\t3\nFrasco vazio de arsenico\tCozinheiro\t5\n' >> "$TEMP/pesos.tsv"
+for acusacao in Mordomo:4 Jardineiro:2 Cozinheiro:0; do
+    suspeito=${acusacao%%:*}
+    esperado="Peso das evidências contra $suspeito: ${acusacao##*:}"
+    printf 'E\nE\nS\n%s\n' "$suspeito" | "$MESTRE" "$TEMP/pesos.tsv" > "$TEMP/pesos.txt"
+    if grep -q "$esperado" "$TEMP/pesos.txt"; then
+        ok "evidências com pesos contra $suspeito"
+    else
+        grep "Peso das evidências" "$TEMP/pesos.txt"
+        falhou "evidências com pesos: esperado \"$esperado\""
+    fi
+done
+
+# Gravação e repetição
+printf 'E\nE\nD\nU\nV\nE\nP\ngoto Cofre\nS\nAdvogado\n' |
+    "$MESTRE" --gravar "$TEMP/partida.dqr" > /dev/null
+if [ "$(head -c 4 "$TEMP/partida.dqr")" != DQR4 ]; then
+    falhou "registro gravado sem o cabeçalho DQR4"
+elif "$MESTRE" --repetir "$TEMP/partida.dqr" --vezes 3 > "$TEMP/repeticao.txt" &&
+     grep -q "Resultados idênticos" "$TEMP/repeticao.txt"; then
+    ok "registro DQR4 repetido com resultados idênticos"
+else
+    cat "$TEMP/repeticao.txt"
+    falhou "repetição do registro DQR4"
+fi
+
+# Gera uma mansão em corredor R0 - R1 - ... com uma pista por sala e o
+# catálogo correspondente: a cada 10 pistas, uma aponta para o Mordomo e
+# as demais para o Advogado, todas com peso 1
+gerarCorredor() {
+    local salas=$1 mansao=$2 catalogo=$3
+    awk -v n="$salas" 'BEGIN {
+        print "entrada\tR0"
+        for (i = 1; i < n; i++) print "porta\tR" i - 1 "\tR" i
+        for (i = 0; i < n; i++) print "pista\tR" i "\tPista " i
+    }' > "$mansao"
+    awk -v n="$salas" 'BEGIN {
+        for (i = 0; i < n; i++) print "Pista " i "\t" (i % 10 == 0 ? "Mordomo" : "Advogado") "\t1"
+    }' > "$catalogo"
+}
+
+# Mansões carregadas: o goto atravessa o corredor inteiro coletando as
+# pistas, e o peso contra o Advogado é 9 a cada 10 pistas
+for salas in 100 5000; do
+    gerarCorredor "$salas" "$TEMP/corredor.tsv" "$TEMP/catalogo.tsv"
+    esperado="Peso das evidências contra Advogado: $((salas / 10 * 9))"
+    printf 'goto R%d\nS\nAdvogado\n' $((salas - 1)) |
+        "$MESTRE" "$TEMP/catalogo.tsv" --mansao "$TEMP/corredor.tsv" > "$TEMP/corredor.txt"
+    if grep -q "$esperado" "$TEMP/corredor.txt"; then
+        ok "corredor de $salas salas e $salas pistas"
+    else
+        grep "Peso das evidências" "$TEMP/corredor.txt"
+        falhou "corredor de $salas salas: esperado \"$esperado\""
+    fi
+done
+
+# Mesma pista em duas salas: depois de desfazer a coleta feita em A, a
+# pista volta a ser coletada em B
+printf 'entrada\tH\nporta\tH\tA\nporta\tH\tB\npista\tA\tFaca suja\npista\tB\tFaca suja\n' > "$TEMP/repetida.tsv"
+printf '1\nV\n2\nU\nV\n2\nS\nX\n' | "$MESTRE" --mansao "$TEMP/repetida.tsv" > "$TEMP/repetida.txt"
+if grep -q '📋 "Faca suja"' "$TEMP/repetida.txt"; then
+    ok "desfazer com a mesma pista em duas salas"
+else
+    falhou "desfazer com a mesma pista em duas salas"
+fi
+
+# Dica com a mesma pista em duas salas: depois de coletá-la em A, a cópia
+# em B não pesa mais, e a dica leva a C
+printf 'entrada\tH\nporta\tH\tA\nporta\tH\tB\nporta\tH\tC\npista\tA\tFaca suja\npista\tB\tFaca suja\npista\tC\tLuva\n' > "$TEMP/repetida.tsv"
+printf 'Faca suja\tMordomo\t5\nLuva\tMordomo\t1\n' > "$TEMP/catalogo.tsv"
+printf '1\nV\nH\nS\nMordomo\n' |
+    "$MESTRE" "$TEMP/catalogo.tsv" --mansao "$TEMP/repetida.tsv" > "$TEMP/dica.txt"
+if grep -q "H → C" "$TEMP/dica.txt"; then
+    ok "dica ignora pista já coletada em outra sala"
+else
+    grep -A1 "💡" "$TEMP/dica.txt"
+    falhou "dica com a mesma pista em duas salas: esperado \"H → C\""
+fi
+
+# Histórico maior que MAX_VERSOES: depois de coletar 100 pistas e
+# desfazer 90, o diário volta a ter 10, e a versão 5 continua consultável
+gerarCorredor 100 "$TEMP/corredor.tsv" "$TEMP/catalogo.tsv"
+{ printf 'goto R99\n'; for i in $(seq 90); do echo U; done; printf 'diario\nversao 5\nS\nX\n'; } |
+    "$MESTRE" "$TEMP/catalogo.tsv" --mansao "$TEMP/corredor.tsv" > "$TEMP/versoes.txt"
+if grep -q "Diário: pistas 1 a 10 de 10" "$TEMP/versoes.txt" &&
+   grep -q 'Versão 5 de 10: depois de "Pista 4"' "$TEMP/versoes.txt"; then
+    ok "histórico com 100 versões e consulta de versão"
+else
+    falhou "histórico com 100 versões e consulta de versão"
+fi
+
+if [ "$falhas" -gt 0 ]; then
+    echo "$falhas verificação(ões) falharam"
+    exit 1
+fi
+echo "Todas as verificações passaram"